@@ -10,7 +10,73 @@
 #include <string.h>
 #include "semver.h"
 
-#define SLICE_SIZE   50
+/*
+ * Define SEMVER_THREADS to build `semver_parse_sort_parallel`, which
+ * runs on POSIX threads (link with -pthread).
+ */
+
+#ifdef SEMVER_THREADS
+#include <pthread.h>
+#endif
+
+/*
+ * SIMD kernels for `semver_is_valid` are enabled when the compiler targets
+ * SSE2. AVX2 is selected at runtime on GCC compatible compilers.
+ * Define SEMVER_NO_SIMD to build the portable scalar version only.
+ */
+
+#if !defined(SEMVER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define SEMVER_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEMVER_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+/*
+ * Numeric components are decoded 8 digits at a time (SWAR) when
+ * unsigned long is 64 bits wide. Define SEMVER_NO_SWAR to disable it.
+ */
+
+#if !defined(SEMVER_NO_SWAR) && ULONG_MAX > 0xffffffffUL
+#define SEMVER_SWAR 1
+#endif
+
+/* Hot helpers called from several places that must always be inlined */
+#if defined(__GNUC__)
+#define ALWAYS_INLINE __inline__ __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE
+#endif
+
+/*
+ * SIMD kernels are picked at runtime the first time they are needed,
+ * through a generic function pointer. Threads racing on a first call
+ * all select and store the same kernel, so the pointer only needs to
+ * be read and written atomically.
+ */
+
+typedef void (*kernel_fn)(void);
+
+#ifdef __ATOMIC_RELAXED
+#define kernel_load(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define kernel_store(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#else
+#define kernel_load(p) (*(p))
+#define kernel_store(p, v) (*(p) = (v))
+#endif
+
+static kernel_fn
+kernel_get (kernel_fn *kernel, kernel_fn (*select)(void)) {
+  kernel_fn fn = kernel_load(kernel);
+  if (fn == NULL) {
+    fn = select();
+    kernel_store(kernel, fn);
+  }
+  return fn;
+}
+
 #define DELIMITER    "."
 #define PR_DELIMITER "-"
 #define MT_DELIMITER "+"
@@ -35,6 +101,166 @@ enum operators {
   SYMBOL_CF = 0x5e
 };
 
+/**
+ * Statistics
+ *
+ * With SEMVER_STATS, each thread counts into its own block, pushed on
+ * a lock-free list the first time it counts anything. Only the owner
+ * writes a block, so counting never contends: snapshots add up every
+ * block, and a reset only moves the baseline subtracted from the sum.
+ * Blocks of finished threads are kept, so their counts are not lost.
+ * Without SEMVER_STATS nothing is counted nor allocated.
+ */
+
+#ifdef SEMVER_STATS
+
+#if defined(__GNUC__)
+#define STATS_THREAD __thread
+#elif defined(_MSC_VER)
+#define STATS_THREAD __declspec(thread)
+#else
+/* No thread local storage: a single block, exact in one thread only */
+#define STATS_THREAD
+#endif
+
+#ifdef __ATOMIC_RELAXED
+#define stats_load(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define stats_store(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define stats_head_load(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define stats_head_cas(p, expected, desired) \
+  __atomic_compare_exchange_n(p, expected, desired, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#else
+#define stats_load(p) (*(p))
+#define stats_store(p, v) (*(p) = (v))
+#define stats_head_load(p) (*(p))
+#define stats_head_cas(p, expected, desired) \
+  (*(p) == *(expected) ? (*(p) = (desired), 1) : (*(expected) = *(p), 0))
+#endif
+
+struct semver_stats_block_s {
+  semver_stats_t stats;
+  struct semver_stats_block_s *next;
+};
+
+static struct semver_stats_block_s *stats_head = NULL;
+static STATS_THREAD struct semver_stats_block_s *stats_local = NULL;
+static semver_stats_t stats_base;
+
+static semver_stats_t *
+stats_register (void) {
+  struct semver_stats_block_s *block;
+
+  /* Not counted as an allocation of the library */
+  block = (struct semver_stats_block_s*)calloc(1, sizeof(*block));
+  if (block == NULL) return NULL;
+
+  block->next = stats_head_load(&stats_head);
+  while (!stats_head_cas(&stats_head, &block->next, block));
+  stats_local = block;
+  return &block->stats;
+}
+
+#define stats_self() (stats_local ? &stats_local->stats : stats_register())
+
+#define STATS_ADD(stat, n) do { \
+    semver_stats_t *s_ = stats_self(); \
+    if (s_) stats_store(&s_->count[stat], stats_load(&s_->count[stat]) + (unsigned long) (n)); \
+  } while (0)
+
+#ifdef SEMVER_STATS_LATENCY
+#define STATS_LATENCY 1
+
+#ifndef SEMVER_STATS_CLOCK
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEMVER_STATS_CLOCK() ((unsigned long) __builtin_ia32_rdtsc())
+#else
+#include <time.h>
+#define SEMVER_STATS_CLOCK() ((unsigned long) clock())
+#endif
+#endif
+
+static void
+stats_latency (unsigned long ticks) {
+  semver_stats_t *s = stats_self();
+  size_t k;
+
+  if (s == NULL) return;
+  for (k = 0; (ticks >>= 1) && k + 1 < SEMVER_STATS_BUCKETS; k++);
+  stats_store(&s->latency[k], stats_load(&s->latency[k]) + 1);
+}
+#endif
+
+static void
+stats_sum (semver_stats_t *stats) {
+  const struct semver_stats_block_s *block;
+  size_t k;
+
+  memset(stats, 0, sizeof(*stats));
+  for (block = stats_head_load(&stats_head); block; block = block->next) {
+    for (k = 0; k < SEMVER_STAT_COUNT; k++) stats->count[k] += stats_load(&block->stats.count[k]);
+    for (k = 0; k < SEMVER_STATS_BUCKETS; k++) stats->latency[k] += stats_load(&block->stats.latency[k]);
+  }
+}
+
+/* Counted heap allocations */
+
+static void *
+mem_alloc (size_t size) {
+  STATS_ADD(SEMVER_STAT_ALLOCS, 1);
+  STATS_ADD(SEMVER_STAT_ALLOC_BYTES, size);
+  return malloc(size);
+}
+
+static void *
+mem_calloc (size_t n, size_t size) {
+  STATS_ADD(SEMVER_STAT_ALLOCS, 1);
+  STATS_ADD(SEMVER_STAT_ALLOC_BYTES, n * size);
+  return calloc(n, size);
+}
+
+#else
+
+#define STATS_ADD(stat, n) do { } while (0)
+#define mem_alloc malloc
+#define mem_calloc calloc
+
+#endif
+
+/**
+ * Copies the counters added up over every thread since the last
+ * `semver_stats_reset` into `stats`. All of them are zero when the
+ * library is compiled without SEMVER_STATS.
+ */
+
+SEMVER_API void
+semver_stats_snapshot (semver_stats_t *stats) {
+#ifdef SEMVER_STATS
+  size_t k;
+
+  stats_sum(stats);
+  for (k = 0; k < SEMVER_STAT_COUNT; k++) stats->count[k] -= stats_load(&stats_base.count[k]);
+  for (k = 0; k < SEMVER_STATS_BUCKETS; k++) stats->latency[k] -= stats_load(&stats_base.latency[k]);
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+/**
+ * Restarts every counter from zero, for all threads.
+ */
+
+SEMVER_API void
+semver_stats_reset (void) {
+#ifdef SEMVER_STATS
+  semver_stats_t sum;
+  size_t k;
+
+  stats_sum(&sum);
+  for (k = 0; k < SEMVER_STAT_COUNT; k++) stats_store(&stats_base.count[k], sum.count[k]);
+  for (k = 0; k < SEMVER_STATS_BUCKETS; k++) stats_store(&stats_base.latency[k], sum.latency[k]);
+#endif
+}
+
 /**
  * Private helpers
  */
@@ -58,70 +284,308 @@ strcut (char *str, int begin, int len) {
 }
 
 static int
-contains (const char c, const char *matrix, size_t len) {
-  size_t x;
-  for (x = 0; x < len; x++)
-    if ((char) matrix[x] == c) return 1;
-  return 0;
+binary_comparison (int x, int y) {
+  if (x == y) return 0;
+  if (x > y) return 1;
+  return -1;
 }
 
-static int
-has_valid_chars (const char *str, const char *matrix) {
-  size_t i, len, mlen;
-  len = strlen(str);
-  mlen = strlen(matrix);
+/**
+ * Numeric parsing
+ *
+ * Digit runs are decoded without libc. With SWAR, 8 bytes are loaded
+ * into a word, the leading digits found with a few bitwise operations
+ * and converted with three multiplications, so a whole component
+ * usually takes a single step.
+ */
 
-  for (i = 0; i < len; i++)
-    if (contains(str[i], matrix, mlen) == 0)
+static const unsigned long powers10[] = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL
+};
+
+#ifdef SEMVER_SWAR
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define swar_load(w, s) memcpy(&(w), (s), 8)
+#else
+#define swar_load(w, s) \
+  ((w) = (unsigned long) (unsigned char) (s)[0] \
+       | (unsigned long) (unsigned char) (s)[1] << 8 \
+       | (unsigned long) (unsigned char) (s)[2] << 16 \
+       | (unsigned long) (unsigned char) (s)[3] << 24 \
+       | (unsigned long) (unsigned char) (s)[4] << 32 \
+       | (unsigned long) (unsigned char) (s)[5] << 40 \
+       | (unsigned long) (unsigned char) (s)[6] << 48 \
+       | (unsigned long) (unsigned char) (s)[7] << 56)
+#endif
+
+/*
+ * Decodes the leading digits of the 8 bytes at `s` into `value`,
+ * returning how many there are. The first byte is the lowest one.
+ */
+static size_t
+swar_digits (const char *s, unsigned long *value) {
+  unsigned long w, nondigit;
+  size_t n;
+
+  swar_load(w, s);
+  w ^= 0x3030303030303030UL;
+  /* Digit bytes are now 0-9: flag any byte with a high nibble after adding 6 */
+  nondigit = (w | (w + 0x0606060606060606UL)) & 0xf0f0f0f0f0f0f0f0UL;
+
+  if (nondigit == 0) {
+    n = 8;
+  } else {
+#ifdef __GNUC__
+    n = (size_t) __builtin_ctzl(nondigit) >> 3;
+#else
+    for (n = 0; !(nondigit & (0xf0UL << (n * 8))); n++);
+#endif
+    if (n == 0) {
+      *value = 0;
       return 0;
+    }
+    /* Keep the digits, shifted up as if preceded by zeros */
+    w <<= (8 - n) * 8;
+  }
 
-  return 1;
+  w = w * 10 + (w >> 8);
+  w = (((w & 0x000000ff000000ffUL) * (100 + (1000000UL << 32)))
+     + (((w >> 16) & 0x000000ff000000ffUL) * (1 + (10000UL << 32)))) >> 32;
+  *value = w;
+  return n;
 }
 
-static int
-binary_comparison (int x, int y) {
-  if (x == y) return 0;
-  if (x > y) return 1;
-  return -1;
+#endif
+
+#define SHORT_DIGITS 4
+
+/* Longest digit run that always fits in an unsigned long */
+#if ULONG_MAX > 0xffffffffUL
+#define NUMBER_DIGITS 19
+#else
+#define NUMBER_DIGITS 9
+#endif
+
+/*
+ * Decodes the digit run at the start of the `avail` bytes at `s`,
+ * storing its length in `len` and its value in `value`. Runs of up to
+ * NUMBER_DIGITS digits cannot overflow, so they are only checked once
+ * against `max` at the end.
+ * Returns -1 if the value is greater than `max`.
+ */
+static ALWAYS_INLINE int
+parse_number (const char *s, size_t avail, unsigned long max, size_t *len, unsigned long *value) {
+  unsigned long v, d;
+  size_t i;
+#ifdef SEMVER_SWAR
+  size_t n;
+#endif
+  v = 0;
+
+  /* Short runs, by far the most common, are cheaper digit by digit */
+  for (i = 0; i < SHORT_DIGITS && i < avail && s[i] >= '0' && s[i] <= '9'; i++)
+    v = v * 10 + (unsigned long) (s[i] - '0');
+
+#ifdef SEMVER_SWAR
+  /* Then whole words while every byte is a digit, the scalar tail otherwise */
+  n = 8;
+  if (i == SHORT_DIGITS) {
+    for (; n == 8 && avail - i >= 8 && i + 8 <= NUMBER_DIGITS; i += n) {
+      n = swar_digits(s + i, &d);
+      v = v * powers10[n] + d;
+    }
+  }
+  if (n == 8)
+#endif
+  for (; i < avail && s[i] >= '0' && s[i] <= '9'; i++) {
+    d = (unsigned long) (s[i] - '0');
+    if (i >= NUMBER_DIGITS && v > (ULONG_MAX - d) / 10) return -1;
+    v = v * 10 + d;
+  }
+
+  if (v > max) return -1;
+  *len = i;
+  *value = v;
+  return 0;
 }
 
 static int
 parse_int (const char *s) {
-  int valid, num;
-  valid = has_valid_chars(s, NUMBERS);
-  if (valid == 0) return -1;
+  unsigned long num;
+  size_t len;
 
-  num = strtol(s, NULL, 10);
-  if (num > MAX_SAFE_INT) return -1;
+  if (parse_number(s, strlen(s), MAX_SAFE_INT, &len, &num)) return -1;
+  if (s[len] != '\0') return -1;
 
-  return num;
+  return (int) num;
 }
 
+/**
+ * Parser state machine.
+ *
+ * `major[.minor[.patch]]` is decoded with `parse_number`, rejecting empty
+ * components and leading zeros. For the prerelease and metadata, every
+ * input byte is mapped to a character class and then drives a transition
+ * table encoding the SemVer 2.0 grammar, so validation and field
+ * extraction happen in a single scan. Leading zeros in numeric prerelease
+ * identifiers and empty identifiers are not accepted.
+ */
+
+enum char_classes {
+  C_OTHER, C_ZERO, C_DIGIT, C_ALPHA, C_HYPHEN, C_DOT, C_PLUS, C_CLASSES
+};
+
+#define OT C_OTHER
+#define ZR C_ZERO
+#define DG C_DIGIT
+#define AL C_ALPHA
+#define HY C_HYPHEN
+#define DT C_DOT
+#define PL C_PLUS
+
+static const unsigned char char_class[256] = {
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, PL, OT, HY, DT, OT,
+  ZR, DG, DG, DG, DG, DG, DG, DG, DG, DG, OT, OT, OT, OT, OT, OT,
+  OT, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,
+  AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, OT, OT, OT, OT, OT,
+  OT, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,
+  AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT
+};
+
+#undef OT
+#undef ZR
+#undef DG
+#undef AL
+#undef HY
+#undef DT
+#undef PL
+
+enum parse_states {
+  P_ERR,
+  P_PR_START, P_PR_ZERO, P_PR_ZEROS, P_PR_NUM, P_PR_ALNUM,
+  P_MT_START, P_MT,
+  P_STATES
+};
+
+static const unsigned char transitions[P_STATES][C_CLASSES] = {
+  /*                other  zero          digit         alpha       hyphen      dot            plus */
+  /* ERR         */ {P_ERR, P_ERR,        P_ERR,        P_ERR,      P_ERR,      P_ERR,         P_ERR},
+  /* PR_START    */ {P_ERR, P_PR_ZERO,    P_PR_NUM,     P_PR_ALNUM, P_PR_ALNUM, P_ERR,         P_ERR},
+  /* PR_ZERO     */ {P_ERR, P_PR_ZEROS,   P_PR_ZEROS,   P_PR_ALNUM, P_PR_ALNUM, P_PR_START,    P_MT_START},
+  /* PR_ZEROS    */ {P_ERR, P_PR_ZEROS,   P_PR_ZEROS,   P_PR_ALNUM, P_PR_ALNUM, P_ERR,         P_ERR},
+  /* PR_NUM      */ {P_ERR, P_PR_NUM,     P_PR_NUM,     P_PR_ALNUM, P_PR_ALNUM, P_PR_START,    P_MT_START},
+  /* PR_ALNUM    */ {P_ERR, P_PR_ALNUM,   P_PR_ALNUM,   P_PR_ALNUM, P_PR_ALNUM, P_PR_START,    P_MT_START},
+  /* MT_START    */ {P_ERR, P_MT,         P_MT,         P_MT,       P_MT,       P_ERR,         P_ERR},
+  /* MT          */ {P_ERR, P_MT,         P_MT,         P_MT,       P_MT,       P_MT_START,    P_ERR}
+};
+
+static const unsigned char state_accepts[P_STATES] = {
+  0, 0, 1, 0, 1, 1, 0, 1
+};
+
 /*
- * Return a string allocated on the heap with the content from sep to end and
- * terminate buf at sep.
+ * Every parser goes through `semver_parse_view`, which counts them.
+ * Inlined so the wrapper costs nothing without SEMVER_STATS.
+ */
+static ALWAYS_INLINE int
+parse_view (const char *str, size_t len, semver_view_t *ver) {
+  size_t i, n, part, pr_start, mt_start;
+  unsigned long parts[3];
+  unsigned char state, next;
+  if (str == NULL || len > MAX_SIZE) return -1;
+
+  parts[0] = parts[1] = parts[2] = 0;
+  pr_start = mt_start = 0;
+
+  for (i = 0, part = 0; ; part++) {
+    if (parse_number(str + i, len - i, MAX_SAFE_INT, &n, &parts[part])) return -1;
+    if (n == 0 || (n > 1 && str[i] == '0')) return -1;
+    i += n;
+    if (i == len || str[i] != DELIMITER[0] || part == 2) break;
+    i++;
+  }
+
+  if (i < len) {
+    if (str[i] == PR_DELIMITER[0]) {
+      state = P_PR_START;
+      pr_start = i + 1;
+    } else if (str[i] == MT_DELIMITER[0]) {
+      state = P_MT_START;
+      mt_start = i + 1;
+    } else {
+      return -1;
+    }
+
+    for (i++; i < len; i++) {
+      next = transitions[state][char_class[(unsigned char) str[i]]];
+      if (next == P_ERR) return -1;
+      if (next == P_MT_START && state < P_MT_START) mt_start = i + 1;
+      state = next;
+    }
+
+    if (!state_accepts[state]) return -1;
+  }
+
+  ver->major = (int) parts[0];
+  ver->minor = (int) parts[1];
+  ver->patch = (int) parts[2];
+  ver->src = str;
+  ver->prerelease.offset = pr_start;
+  ver->prerelease.len = pr_start ? (mt_start ? mt_start - 1 : len) - pr_start : 0;
+  ver->metadata.offset = mt_start;
+  ver->metadata.len = mt_start ? len - mt_start : 0;
+
+  return 0;
+}
+
+/**
+ * Parses `len` bytes of `str` as semver expression into a borrowed view.
+ * The input does not need to be NUL terminated and no memory is
+ * allocated: prerelease and metadata point back into `str`, which
+ * must outlive the view.
+ *
+ * Returns:
+ *
+ * `0` - Parsed successfully
+ * `-1` - Parse error or invalid
  */
-static char *
-parse_slice (char *buf, char sep) {
-  char *pr, *part;
-  int plen;
-
-  /* Find separator in buf */
-  pr = strchr(buf, sep);
-  if (pr == NULL) return NULL;
-  /* Length from separator to end of buf */
-  plen = strlen(pr);
-
-  /* Copy from buf into new string */
-  part = (char*)calloc(plen + 1, sizeof(*part));
-  if (part == NULL) return NULL;
-  memcpy(part, pr + 1, plen);
-  /* Null terminate new string */
-  part[plen] = '\0';
 
-  /* Terminate buf where separator was */
-  *pr = '\0';
+SEMVER_API int
+semver_parse_view (const char *str, size_t len, semver_view_t *ver) {
+  int res;
+#ifdef STATS_LATENCY
+  unsigned long start = SEMVER_STATS_CLOCK();
+  res = parse_view(str, len, ver);
+  stats_latency(SEMVER_STATS_CLOCK() - start);
+#else
+  res = parse_view(str, len, ver);
+#endif
+  STATS_ADD(SEMVER_STAT_PARSE, 1);
+  if (res) STATS_ADD(SEMVER_STAT_PARSE_INVALID, 1);
+  return res;
+}
 
+/*
+ * Return a NUL terminated copy of a view slice allocated on the heap.
+ */
+static char *
+slice_dup (const char *src, semver_slice_t slice) {
+  char *part;
+  part = (char*)mem_alloc(slice.len + 1);
+  if (part == NULL) return NULL;
+  memcpy(part, src + slice.offset, slice.len);
+  part[slice.len] = '\0';
   return part;
 }
 
@@ -134,32 +598,41 @@ parse_slice (char *buf, char sep) {
  * `-1` - In case of error
  */
 
-int
+SEMVER_API int
 semver_parse (const char *str, semver_t *ver) {
-  int valid, res;
-  size_t len;
-  char *buf;
-  valid = semver_is_valid(str);
-  if (!valid) return -1;
+  semver_view_t view;
+  char *prerelease, *metadata;
+  prerelease = metadata = NULL;
 
-  len = strlen(str);
-  buf = (char*)calloc(len + 1, sizeof(*buf));
-  if (buf == NULL) return -1;
-  strcpy(buf, str);
+  if (semver_parse_view(str, strlen(str), &view)) return -1;
 
-  ver->metadata = parse_slice(buf, MT_DELIMITER[0]);
-  ver->prerelease = parse_slice(buf, PR_DELIMITER[0]);
+  if (view.prerelease.len) {
+    prerelease = slice_dup(str, view.prerelease);
+    if (prerelease == NULL) return -1;
+  }
 
-  res = semver_parse_version(buf, ver);
-  free(buf);
+  if (view.metadata.len) {
+    metadata = slice_dup(str, view.metadata);
+    if (metadata == NULL) {
+      free(prerelease);
+      return -1;
+    }
+  }
+
+  ver->major = view.major;
+  ver->minor = view.minor;
+  ver->patch = view.patch;
+  ver->prerelease = prerelease;
+  ver->metadata = metadata;
 #if DEBUG > 0
   printf("[debug] semver.c %s = %d.%d.%d, %s %s\n", str, ver->major, ver->minor, ver->patch, ver->prerelease, ver->metadata);
 #endif
-  return res;
+  return 0;
 }
 
 /**
  * Parses a given string as semver expression.
+ * Only the `major[.minor[.patch]]` part is accepted.
  *
  * Returns:
  *
@@ -167,136 +640,539 @@ semver_parse (const char *str, semver_t *ver) {
  * `-1` - Parse error or invalid
  */
 
-int
+SEMVER_API int
 semver_parse_version (const char *str, semver_t *ver) {
-  size_t len;
-  int index, value;
-  char *slice, *next, *endptr;
-  slice = (char *) str;
-  index = 0;
-
-  while (slice != NULL && index++ < 4) {
-    next = strchr(slice, DELIMITER[0]);
-    if (next == NULL)
-      len = strlen(slice);
-    else
-      len = next - slice;
-    if (len > SLICE_SIZE) return -1;
+  semver_view_t view;
 
-    /* Cast to integer and store */
-    value = strtol(slice, &endptr, 10);
-    if (endptr != next && *endptr != '\0') return -1;
-
-    switch (index) {
-      case 1: ver->major = value; break;
-      case 2: ver->minor = value; break;
-      case 3: ver->patch = value; break;
-    }
+  if (semver_parse_view(str, strlen(str), &view)) return -1;
+  if (view.prerelease.len || view.metadata.len) return -1;
 
-    /* Continue with the next slice */
-    if (next == NULL)
-      slice = NULL;
-    else
-      slice = next + 1;
-  }
+  ver->major = view.major;
+  ver->minor = view.minor;
+  ver->patch = view.patch;
 
   return 0;
 }
 
-static int
-compare_prerelease (char *x, char *y) {
-  char *lastx, *lasty, *xptr, *yptr, *endptr;
-  int xlen, ylen, xisnum, yisnum, xnum, ynum;
-  int xn, yn, min, res;
-  if (x == NULL && y == NULL) return 0;
-  if (y == NULL && x) return -1;
-  if (x == NULL && y) return 1;
+/*
+ * Copy a view slice into `block` as a NUL terminated string,
+ * returning the copy and advancing the block pointer.
+ */
+static char *
+slice_copy (const char *src, semver_slice_t slice, char **block) {
+  char *part;
+  part = *block;
+  memcpy(part, src + slice.offset, slice.len);
+  part[slice.len] = '\0';
+  *block += slice.len + 1;
+  return part;
+}
 
-  lastx = x;
-  lasty = y;
-  xlen = strlen(x);
-  ylen = strlen(y);
+/**
+ * Parses an array of `n` strings into the caller owned `out` array.
+ *
+ * Every prerelease and metadata string is stored in a single contiguous
+ * block returned in `block` (NULL if there are none), so the whole batch
+ * is released with one `free(*block)`. Do not call `semver_free`
+ * on the parsed items.
+ *
+ * If `status` is not NULL, `status[i]` is set to `0` if `strs[i]` was
+ * parsed or `-1` if it was invalid, in which case `out[i]` is zeroed.
+ *
+ * Returns:
+ *
+ * `0` - Batch processed
+ * `-1` - Memory allocation error
+ */
 
-  while (1) {
-    if ((xptr = strchr(lastx, DELIMITER[0])) == NULL)
-      xptr = x + xlen;
-    if ((yptr = strchr(lasty, DELIMITER[0])) == NULL)
-      yptr = y + ylen;
+SEMVER_API int
+semver_parse_batch (const char **strs, size_t n, semver_t *out, int *status, char **block) {
+  semver_view_t *views;
+  size_t i, size;
+  char *next;
+  *block = NULL;
+  if (n == 0) return 0;
 
-    xnum = strtol(lastx, &endptr, 10);
-    xisnum = endptr == xptr ? 1 : 0;
-    ynum = strtol(lasty, &endptr, 10);
-    yisnum = endptr == yptr ? 1 : 0;
+  views = (semver_view_t*)mem_alloc(n * sizeof(*views));
+  if (views == NULL) return -1;
 
-    if (xisnum && !yisnum) return -1;
-    if (!xisnum && yisnum) return 1;
+  size = 0;
+  for (i = 0; i < n; i++) {
+    if (strs[i] == NULL || semver_parse_view(strs[i], strlen(strs[i]), &views[i])) {
+      views[i].src = NULL;
+      continue;
+    }
+    if (views[i].prerelease.len) size += views[i].prerelease.len + 1;
+    if (views[i].metadata.len) size += views[i].metadata.len + 1;
+  }
 
-    if (xisnum && yisnum) {
-      /* Numerical comparison */
-      if (xnum != ynum) return xnum < ynum ? -1 : 1;
-    } else {
-      /* String comparison */
-      xn = xptr - lastx;
-      yn = yptr - lasty;
-      min = xn < yn ? xn : yn;
-      if ((res = strncmp(lastx, lasty, min))) return res < 0 ? -1 : 1;
-      if (xn != yn) return xn < yn ? -1 : 1;
+  if (size) {
+    *block = (char*)mem_alloc(size);
+    if (*block == NULL) {
+      free(views);
+      return -1;
     }
+  }
 
-    lastx = xptr + 1;
-    lasty = yptr + 1;
-    if (lastx == x + xlen + 1 && lasty == y + ylen + 1) break;
-    if (lastx == x + xlen + 1) return -1;
-    if (lasty == y + ylen + 1) return 1;
+  next = *block;
+  for (i = 0; i < n; i++) {
+    if (status) status[i] = views[i].src ? 0 : -1;
+    if (views[i].src == NULL) {
+      memset(&out[i], 0, sizeof(out[i]));
+      continue;
+    }
+    out[i].major = views[i].major;
+    out[i].minor = views[i].minor;
+    out[i].patch = views[i].patch;
+    out[i].prerelease = views[i].prerelease.len
+      ? slice_copy(views[i].src, views[i].prerelease, &next) : NULL;
+    out[i].metadata = views[i].metadata.len
+      ? slice_copy(views[i].src, views[i].metadata, &next) : NULL;
   }
 
+  free(views);
   return 0;
 }
 
-int
-semver_compare_prerelease (semver_t x, semver_t y) {
-  return compare_prerelease(x.prerelease, y.prerelease);
-}
-
 /**
- * Performs a major, minor and patch binary comparison (x, y).
- * This function is mostly used internally
+ * Arena allocator
  *
- * Returns:
- *
- * `0` - If versiona are equal
- * `1` - If x is higher than y
- * `-1` - If x is lower than y
+ * Prerelease and metadata strings are bump allocated from a list of
+ * chunks. Resetting rewinds to the first chunk so memory is reused by
+ * the next batch, and destroying the arena frees every chunk at once.
  */
 
-int
-semver_compare_version (semver_t x, semver_t y) {
-  int res;
+#define ARENA_CHUNK_SIZE 65536
+
+struct semver_arena_chunk_s {
+  struct semver_arena_chunk_s *next;
+  size_t size;
+  size_t used;
+};
+
+#define chunk_data(chunk) ((char *) ((chunk) + 1))
+
+static struct semver_arena_chunk_s *
+arena_chunk (size_t size) {
+  struct semver_arena_chunk_s *chunk;
+  chunk = (struct semver_arena_chunk_s*)mem_alloc(sizeof(*chunk) + size);
+  if (chunk == NULL) return NULL;
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  return chunk;
+}
 
-  if ((res = binary_comparison(x.major, y.major)) == 0) {
-    if ((res = binary_comparison(x.minor, y.minor)) == 0) {
-      return binary_comparison(x.patch, y.patch);
+static char *
+arena_alloc (semver_arena_t *arena, size_t size) {
+  struct semver_arena_chunk_s *chunk, *next;
+  char *ptr;
+
+  chunk = arena->current;
+  if (chunk == NULL || chunk->size - chunk->used < size) {
+    next = chunk ? chunk->next : arena->head;
+    if (next && next->size >= size) {
+      /* Reuse a chunk kept by a previous reset */
+      next->used = 0;
+    } else {
+      next = arena_chunk(size > arena->chunk_size ? size : arena->chunk_size);
+      if (next == NULL) return NULL;
+      if (chunk) {
+        next->next = chunk->next;
+        chunk->next = next;
+      } else {
+        next->next = arena->head;
+        arena->head = next;
+      }
     }
+    arena->current = chunk = next;
   }
 
-  return res;
+  ptr = chunk_data(chunk) + chunk->used;
+  chunk->used += size;
+  return ptr;
 }
 
 /**
- * Compare two semantic versions (x, y).
+ * Initializes an arena allocating chunks of `chunk_size` bytes,
+ * or a default size if `chunk_size` is `0`. No memory is allocated
+ * until the first parse.
+ */
+
+SEMVER_API void
+semver_arena_init (semver_arena_t *arena, size_t chunk_size) {
+  arena->head = NULL;
+  arena->current = NULL;
+  arena->chunk_size = chunk_size ? chunk_size : ARENA_CHUNK_SIZE;
+}
+
+/**
+ * Parses a string as semver expression, allocating prerelease and
+ * metadata from `arena`. The parsed version is valid until the arena
+ * is reset or destroyed and must not be passed to `semver_free`.
  *
  * Returns:
- * - `1` if x is higher than y
- * - `0` if x is equal to y
- * - `-1` if x is lower than y
+ *
+ * `0` - Parsed successfully
+ * `-1` - Parse error, invalid or memory allocation error
  */
 
-int
+SEMVER_API int
+semver_parse_arena (semver_arena_t *arena, const char *str, semver_t *ver) {
+  semver_view_t view;
+  size_t size;
+  char *block;
+
+  if (semver_parse_view(str, strlen(str), &view)) return -1;
+
+  size = (view.prerelease.len ? view.prerelease.len + 1 : 0)
+       + (view.metadata.len ? view.metadata.len + 1 : 0);
+  block = NULL;
+  if (size && (block = arena_alloc(arena, size)) == NULL) return -1;
+
+  ver->major = view.major;
+  ver->minor = view.minor;
+  ver->patch = view.patch;
+  ver->prerelease = view.prerelease.len
+    ? slice_copy(str, view.prerelease, &block) : NULL;
+  ver->metadata = view.metadata.len
+    ? slice_copy(str, view.metadata, &block) : NULL;
+
+  return 0;
+}
+
+/**
+ * Releases every version parsed from `arena` in O(1).
+ * Chunks are kept and reused by the following parses.
+ */
+
+SEMVER_API void
+semver_arena_reset (semver_arena_t *arena) {
+  arena->current = arena->head;
+  if (arena->head) arena->head->used = 0;
+}
+
+/**
+ * Frees all the memory owned by `arena`.
+ */
+
+SEMVER_API void
+semver_arena_destroy (semver_arena_t *arena) {
+  struct semver_arena_chunk_s *chunk, *next;
+  for (chunk = arena->head; chunk; chunk = next) {
+    next = chunk->next;
+    free(chunk);
+  }
+  arena->head = NULL;
+  arena->current = NULL;
+}
+
+/*
+ * Returns 1 if the `len` bytes at `s` are a non-empty run of digits.
+ */
+static int
+is_numeric (const char *s, size_t len) {
+  size_t i;
+  if (len == 0) return 0;
+  for (i = 0; i < len; i++)
+    if (s[i] < '0' || s[i] > '9') return 0;
+  return 1;
+}
+
+/*
+ * Compares two digit runs by numeric value without converting them,
+ * so identifiers of any length can be compared without overflow.
+ */
+static int
+compare_numeric (const char *x, size_t xlen, const char *y, size_t ylen) {
+  size_t i;
+  while (xlen > 1 && *x == '0') { x++; xlen--; }
+  while (ylen > 1 && *y == '0') { y++; ylen--; }
+  if (xlen != ylen) return xlen < ylen ? -1 : 1;
+  for (i = 0; i < xlen; i++)
+    if (x[i] != y[i]) return x[i] < y[i] ? -1 : 1;
+  return 0;
+}
+
+/*
+ * Compares two prerelease strings given as (pointer, length) pairs.
+ * A NULL pointer means no prerelease, which has higher precedence.
+ * Neither string needs to be NUL terminated.
+ */
+static int
+compare_prerelease_n (const char *x, size_t xlen, const char *y, size_t ylen) {
+  const char *xend, *yend, *xptr, *yptr;
+  size_t xn, yn, min, i;
+  int xisnum, yisnum, res;
+  if (x == NULL && y == NULL) return 0;
+  if (y == NULL && x) return -1;
+  if (x == NULL && y) return 1;
+  STATS_ADD(SEMVER_STAT_PRERELEASE_COMPARE, 1);
+
+  xend = x + xlen;
+  yend = y + ylen;
+
+  while (1) {
+    for (xptr = x; xptr < xend && *xptr != DELIMITER[0]; xptr++);
+    for (yptr = y; yptr < yend && *yptr != DELIMITER[0]; yptr++);
+    xn = xptr - x;
+    yn = yptr - y;
+
+    xisnum = is_numeric(x, xn);
+    yisnum = is_numeric(y, yn);
+
+    if (xisnum && !yisnum) return -1;
+    if (!xisnum && yisnum) return 1;
+
+    if (xisnum && yisnum) {
+      /* Numerical comparison */
+      if ((res = compare_numeric(x, xn, y, yn))) return res;
+    } else {
+      /* String comparison */
+      STATS_ADD(SEMVER_STAT_PRERELEASE_STRING, 1);
+      min = xn < yn ? xn : yn;
+      for (i = 0; i < min; i++)
+        if (x[i] != y[i]) return (unsigned char) x[i] < (unsigned char) y[i] ? -1 : 1;
+      if (xn != yn) return xn < yn ? -1 : 1;
+    }
+
+    if (xptr == xend && yptr == yend) break;
+    if (xptr == xend) return -1;
+    if (yptr == yend) return 1;
+    x = xptr + 1;
+    y = yptr + 1;
+  }
+
+  return 0;
+}
+
+static int
+compare_prerelease (const char *x, const char *y) {
+  return compare_prerelease_n(x, x ? strlen(x) : 0, y, y ? strlen(y) : 0);
+}
+
+/**
+ * Pre-tokenized prereleases
+ *
+ * Identifiers are split once, recording whether each one is numeric.
+ * Numeric identifiers keep their significant digit count and, when
+ * short enough, their value, so they compare by length then value
+ * (or digits) without ever overflowing.
+ */
+
+#define IDENTIFIER_VALUE_DIGITS 9
+
+/**
+ * Splits `len` bytes of a prerelease (without the leading `-`)
+ * into identifiers. A NULL `str` stands for no prerelease.
+ *
+ * Returns:
+ *
+ * `0` - Tokenized successfully
+ * `-1` - More than SEMVER_MAX_IDENTIFIERS identifiers or too long
+ */
+
+SEMVER_API int
+semver_prerelease_tokenize (const char *str, size_t len, semver_prerelease_t *pr) {
+  semver_identifier_t *id;
+  size_t i, j, start;
+
+  pr->src = str;
+  pr->count = 0;
+  if (str == NULL) return 0;
+  if (len > MAX_SIZE) return -1;
+
+  for (start = 0; start <= len; start = i + 1) {
+    for (i = start; i < len && str[i] != DELIMITER[0]; i++);
+    if (pr->count == SEMVER_MAX_IDENTIFIERS) return -1;
+
+    id = &pr->ids[pr->count++];
+    id->offset = (unsigned char) start;
+    id->len = (unsigned char) (i - start);
+    id->numeric = (unsigned char) is_numeric(str + start, i - start);
+    id->value = 0;
+
+    if (id->numeric) {
+      /* Skip leading zeros so that the length orders numbers */
+      while (id->len > 1 && str[id->offset] == '0') { id->offset++; id->len--; }
+      if (id->len <= IDENTIFIER_VALUE_DIGITS)
+        parse_number(str + id->offset, len - id->offset, ULONG_MAX, &j, &id->value);
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Parses like `semver_parse_view`, also tokenizing the prerelease.
+ *
+ * Returns:
+ *
+ * `0` - Parsed successfully
+ * `-1` - Parse error, invalid or too many identifiers
+ */
+
+SEMVER_API int
+semver_parse_tokens (const char *str, size_t len, semver_view_t *ver, semver_prerelease_t *pr) {
+  if (semver_parse_view(str, len, ver)) return -1;
+  return semver_prerelease_tokenize(
+    ver->prerelease.len ? str + ver->prerelease.offset : NULL, ver->prerelease.len, pr);
+}
+
+/**
+ * Compare two tokenized prereleases with SemVer precedence rules.
+ *
+ * Returns:
+ * - `1` if x is higher than y
+ * - `0` if x is equal to y
+ * - `-1` if x is lower than y
+ */
+
+SEMVER_API int
+semver_prerelease_compare (const semver_prerelease_t *x, const semver_prerelease_t *y) {
+  const semver_identifier_t *a, *b;
+  const char *as, *bs;
+  size_t i, j, min;
+
+  if (x->src == NULL || y->src == NULL) {
+    if (x->src == y->src) return 0;
+    return x->src == NULL ? 1 : -1;
+  }
+  STATS_ADD(SEMVER_STAT_PRERELEASE_COMPARE, 1);
+
+  min = x->count < y->count ? x->count : y->count;
+  for (i = 0; i < min; i++) {
+    a = &x->ids[i];
+    b = &y->ids[i];
+    if (a->numeric != b->numeric) return a->numeric ? -1 : 1;
+
+    if (a->numeric) {
+      if (a->len != b->len) return a->len < b->len ? -1 : 1;
+      if (a->len <= IDENTIFIER_VALUE_DIGITS) {
+        if (a->value != b->value) return a->value < b->value ? -1 : 1;
+        continue;
+      }
+    }
+
+    if (!a->numeric) STATS_ADD(SEMVER_STAT_PRERELEASE_STRING, 1);
+    as = x->src + a->offset;
+    bs = y->src + b->offset;
+    for (j = 0; j < a->len && j < b->len; j++)
+      if (as[j] != bs[j]) return (unsigned char) as[j] < (unsigned char) bs[j] ? -1 : 1;
+    if (a->len != b->len) return a->len < b->len ? -1 : 1;
+  }
+
+  if (x->count != y->count) return x->count < y->count ? -1 : 1;
+  return 0;
+}
+
+SEMVER_API int
+semver_compare_prerelease (semver_t x, semver_t y) {
+  return semver_compare_prerelease_ptr(&x, &y);
+}
+
+SEMVER_API int
+semver_compare_prerelease_ptr (const semver_t *x, const semver_t *y) {
+  return compare_prerelease(x->prerelease, y->prerelease);
+}
+
+SEMVER_API int
+semver_view_compare_prerelease (const semver_view_t *x, const semver_view_t *y) {
+  return compare_prerelease_n(
+    x->prerelease.len ? x->src + x->prerelease.offset : NULL, x->prerelease.len,
+    y->prerelease.len ? y->src + y->prerelease.offset : NULL, y->prerelease.len);
+}
+
+/**
+ * Performs a major, minor and patch binary comparison (x, y).
+ * This function is mostly used internally
+ *
+ * Returns:
+ *
+ * `0` - If versiona are equal
+ * `1` - If x is higher than y
+ * `-1` - If x is lower than y
+ */
+
+SEMVER_API int
+semver_compare_version (semver_t x, semver_t y) {
+  return semver_compare_version_ptr(&x, &y);
+}
+
+SEMVER_API int
+semver_compare_version_ptr (const semver_t *x, const semver_t *y) {
+  int res;
+
+  if ((res = binary_comparison(x->major, y->major)) == 0) {
+    if ((res = binary_comparison(x->minor, y->minor)) == 0) {
+      return binary_comparison(x->patch, y->patch);
+    }
+  }
+
+  return res;
+}
+
+/**
+ * Compare two semantic versions (x, y).
+ *
+ * Returns:
+ * - `1` if x is higher than y
+ * - `0` if x is equal to y
+ * - `-1` if x is lower than y
+ */
+
+SEMVER_API int
 semver_compare (semver_t x, semver_t y) {
+  return semver_compare_ptr(&x, &y);
+}
+
+/**
+ * Same as `semver_compare`, taking the versions by pointer.
+ */
+
+SEMVER_API int
+semver_compare_ptr (const semver_t *x, const semver_t *y) {
+  int res;
+  STATS_ADD(SEMVER_STAT_COMPARE, 1);
+
+  if ((res = semver_compare_version_ptr(x, y)) == 0) {
+    return semver_compare_prerelease_ptr(x, y);
+  }
+
+  return res;
+}
+
+/**
+ * `qsort` and `bsearch` compatible comparators over arrays of semver_t,
+ * ordering versions in ascending or descending order.
+ */
+
+SEMVER_API int
+semver_compare_asc (const void *x, const void *y) {
+  return semver_compare_ptr((const semver_t *) x, (const semver_t *) y);
+}
+
+SEMVER_API int
+semver_compare_desc (const void *x, const void *y) {
+  return semver_compare_ptr((const semver_t *) y, (const semver_t *) x);
+}
+
+/**
+ * Compare two semantic version views (x, y).
+ * Same semantics as `semver_compare`, without copying or allocating.
+ */
+
+SEMVER_API int
+semver_view_compare (const semver_view_t *x, const semver_view_t *y) {
   int res;
+  STATS_ADD(SEMVER_STAT_COMPARE, 1);
 
-  if ((res = semver_compare_version(x, y)) == 0) {
-    return semver_compare_prerelease(x, y);
+  if ((res = binary_comparison(x->major, y->major)) == 0) {
+    if ((res = binary_comparison(x->minor, y->minor)) == 0) {
+      if ((res = binary_comparison(x->patch, y->patch)) == 0) {
+        return semver_view_compare_prerelease(x, y);
+      }
+    }
   }
 
   return res;
@@ -306,54 +1182,84 @@ semver_compare (semver_t x, semver_t y) {
  * Performs a `greater than` comparison
  */
 
-int
+SEMVER_API int
 semver_gt (semver_t x, semver_t y) {
-  return semver_compare(x, y) == 1;
+  return semver_compare_ptr(&x, &y) == 1;
+}
+
+SEMVER_API int
+semver_gt_ptr (const semver_t *x, const semver_t *y) {
+  return semver_compare_ptr(x, y) == 1;
 }
 
 /**
  * Performs a `lower than` comparison
  */
 
-int
+SEMVER_API int
 semver_lt (semver_t x, semver_t y) {
-  return semver_compare(x, y) == -1;
+  return semver_compare_ptr(&x, &y) == -1;
+}
+
+SEMVER_API int
+semver_lt_ptr (const semver_t *x, const semver_t *y) {
+  return semver_compare_ptr(x, y) == -1;
 }
 
 /**
  * Performs a `equality` comparison
  */
 
-int
+SEMVER_API int
 semver_eq (semver_t x, semver_t y) {
-  return semver_compare(x, y) == 0;
+  return semver_compare_ptr(&x, &y) == 0;
+}
+
+SEMVER_API int
+semver_eq_ptr (const semver_t *x, const semver_t *y) {
+  return semver_compare_ptr(x, y) == 0;
 }
 
 /**
  * Performs a `non equal to` comparison
  */
 
-int
+SEMVER_API int
 semver_neq (semver_t x, semver_t y) {
-  return semver_compare(x, y) != 0;
+  return semver_compare_ptr(&x, &y) != 0;
+}
+
+SEMVER_API int
+semver_neq_ptr (const semver_t *x, const semver_t *y) {
+  return semver_compare_ptr(x, y) != 0;
 }
 
 /**
  * Performs a `greater than or equal` comparison
  */
 
-int
+SEMVER_API int
 semver_gte (semver_t x, semver_t y) {
-  return semver_compare(x, y) >= 0;
+  return semver_compare_ptr(&x, &y) >= 0;
+}
+
+SEMVER_API int
+semver_gte_ptr (const semver_t *x, const semver_t *y) {
+  return semver_compare_ptr(x, y) >= 0;
 }
 
 /**
  * Performs a `lower than or equal` comparison
  */
 
-int
+SEMVER_API int
 semver_lte (semver_t x, semver_t y) {
-  return semver_compare(x, y) <= 0;
+  return semver_compare_ptr(&x, &y) <= 0;
+}
+
+SEMVER_API int
+semver_lte_ptr (const semver_t *x, const semver_t *y) {
+  return semver_compare_ptr(x, y) <= 0;
 }
 
 /**
@@ -368,30 +1274,31 @@ semver_lte (semver_t x, semver_t y) {
  * `0` - Cannot be satisfied
  */
 
-int
-semver_satisfies_caret (semver_t x, semver_t y) {
+static int
+satisfies_caret (int xmajor, int xminor, int xpatch,
+                 int ymajor, int yminor, int ypatch) {
   /* Major versions must always match. */
-  if (x.major == y.major) {
+  if (xmajor == ymajor) {
     /* If major version is 0, minor versions must match */
-    if (x.major == 0) {
+    if (xmajor == 0) {
         /* If minor version is 0, patch must match */
-        if (x.minor == 0){
-          return (x.minor == y.minor) && (x.patch == y.patch);
+        if (xminor == 0){
+          return (xminor == yminor) && (xpatch == ypatch);
         }
         /* If minor version is not 0, patch must be >= */
-        else if (x.minor == y.minor){
-          return x.patch >= y.patch;
+        else if (xminor == yminor){
+          return xpatch >= ypatch;
         }
         else{
           return 0;
         }
       }
-    else if (x.minor > y.minor){
+    else if (xminor > yminor){
       return 1;
     }
-    else if (x.minor == y.minor)
+    else if (xminor == yminor)
     {
-      return x.patch >= y.patch;
+      return xpatch >= ypatch;
     }
     else {
       return 0;
@@ -400,6 +1307,24 @@ semver_satisfies_caret (semver_t x, semver_t y) {
   return 0;
 }
 
+SEMVER_API int
+semver_satisfies_caret (semver_t x, semver_t y) {
+  return satisfies_caret(x.major, x.minor, x.patch,
+                         y.major, y.minor, y.patch);
+}
+
+SEMVER_API int
+semver_satisfies_caret_ptr (const semver_t *x, const semver_t *y) {
+  return satisfies_caret(x->major, x->minor, x->patch,
+                         y->major, y->minor, y->patch);
+}
+
+SEMVER_API int
+semver_view_satisfies_caret (const semver_view_t *x, const semver_view_t *y) {
+  return satisfies_caret(x->major, x->minor, x->patch,
+                         y->major, y->minor, y->patch);
+}
+
 /**
  * Checks if version `x` can be satisfied by `y`
  * performing a comparison with tilde operator.
@@ -412,12 +1337,57 @@ semver_satisfies_caret (semver_t x, semver_t y) {
  * `0` - Cannot be satisfied
  */
 
-int
+SEMVER_API int
 semver_satisfies_patch (semver_t x, semver_t y) {
   return x.major == y.major
       && x.minor == y.minor;
 }
 
+SEMVER_API int
+semver_satisfies_patch_ptr (const semver_t *x, const semver_t *y) {
+  return x->major == y->major
+      && x->minor == y->minor;
+}
+
+SEMVER_API int
+semver_view_satisfies_patch (const semver_view_t *x, const semver_view_t *y) {
+  return x->major == y->major
+      && x->minor == y->minor;
+}
+
+/*
+ * Applies a relational operator (`=`, `>`, `>=`, `<`, `<=`)
+ * to the result of a comparison.
+ */
+static int
+satisfies_operator (const char *op, int res) {
+  int first, second;
+  first = op[0];
+  second = op[1];
+
+  /* Strict equality */
+  if (first == SYMBOL_EQ)
+    return res == 0;
+
+  /* Greater than or equal comparison */
+  if (first == SYMBOL_GT) {
+    if (second == SYMBOL_EQ) {
+      return res >= 0;
+    }
+    return res > 0;
+  }
+
+  /* Lower than or equal comparison */
+  if (first == SYMBOL_LT) {
+    if (second == SYMBOL_EQ) {
+      return res <= 0;
+    }
+    return res < 0;
+  }
+
+  return 0;
+}
+
 /**
  * Checks if both versions can be satisfied
  * based on the given comparison operator.
@@ -438,51 +1408,147 @@ semver_satisfies_patch (semver_t x, semver_t y) {
  * `0` - Cannot be satisfied
  */
 
-int
+SEMVER_API int
 semver_satisfies (semver_t x, semver_t y, const char *op) {
-  int first, second;
-  /* Extract the comparison operator */
-  first = op[0];
-  second = op[1];
+  return semver_satisfies_ptr(&x, &y, op);
+}
+
+/**
+ * Same as `semver_satisfies`, taking the versions by pointer.
+ */
+
+SEMVER_API int
+semver_satisfies_ptr (const semver_t *x, const semver_t *y, const char *op) {
+  STATS_ADD(SEMVER_STAT_SATISFIES, 1);
 
   /* Caret operator */
-  if (first == SYMBOL_CF)
-    return semver_satisfies_caret(x, y);
+  if (op[0] == SYMBOL_CF)
+    return semver_satisfies_caret_ptr(x, y);
 
   /* Tilde operator */
-  if (first == SYMBOL_TF)
-    return semver_satisfies_patch(x, y);
+  if (op[0] == SYMBOL_TF)
+    return semver_satisfies_patch_ptr(x, y);
 
-  /* Strict equality */
-  if (first == SYMBOL_EQ)
-    return semver_eq(x, y);
+  return satisfies_operator(op, semver_compare_ptr(x, y));
+}
 
-  /* Greater than or equal comparison */
-  if (first == SYMBOL_GT) {
-    if (second == SYMBOL_EQ) {
-      return semver_gte(x, y);
-    }
-    return semver_gt(x, y);
-  }
+/**
+ * Same as `semver_satisfies` for borrowed version views.
+ */
 
-  /* Lower than or equal comparison */
-  if (first == SYMBOL_LT) {
-    if (second == SYMBOL_EQ) {
-      return semver_lte(x, y);
-    }
-    return semver_lt(x, y);
-  }
+SEMVER_API int
+semver_view_satisfies (const semver_view_t *x, const semver_view_t *y, const char *op) {
+  STATS_ADD(SEMVER_STAT_SATISFIES, 1);
+
+  if (op[0] == SYMBOL_CF)
+    return semver_view_satisfies_caret(x, y);
+
+  if (op[0] == SYMBOL_TF)
+    return semver_view_satisfies_patch(x, y);
 
+  return satisfies_operator(op, semver_view_compare(x, y));
+}
+
+/*
+ * Splits the leading operator of an expression, returning its length.
+ * `~>` is an alias of `~`. Without operator, `op` is `SEMVER_OP_EQ`.
+ */
+static size_t
+parse_operator (const char *s, size_t len, semver_op_t *op) {
+  *op = SEMVER_OP_EQ;
+  if (len == 0) return 0;
+  if (len > 1 && s[1] == SYMBOL_EQ) {
+    if (s[0] == SYMBOL_GT) { *op = SEMVER_OP_GTE; return 2; }
+    if (s[0] == SYMBOL_LT) { *op = SEMVER_OP_LTE; return 2; }
+  }
+  if (len > 1 && s[0] == SYMBOL_TF && s[1] == SYMBOL_GT) { *op = SEMVER_OP_TILDE; return 2; }
+  switch (s[0]) {
+    case SYMBOL_GT: *op = SEMVER_OP_GT; return 1;
+    case SYMBOL_LT: *op = SEMVER_OP_LT; return 1;
+    case SYMBOL_EQ: *op = SEMVER_OP_EQ; return 1;
+    case SYMBOL_TF: *op = SEMVER_OP_TILDE; return 1;
+    case SYMBOL_CF: *op = SEMVER_OP_CARET; return 1;
+  }
   return 0;
 }
 
 /**
- * Free heep allocated memory of a given semver.
- * This is just a convenient function that you
+ * Decodes a comparison operator (`=`, `>`, `>=`, `<`, `<=`, `~`, `~>`
+ * or `^`) once, so it can be applied with `semver_satisfies_op`
+ * without decoding the string again.
+ *
+ * Returns:
+ *
+ * `0` - Valid operator
+ * `-1` - Unknown operator
+ */
+
+SEMVER_API int
+semver_op_parse (const char *str, semver_op_t *op) {
+  size_t len = strlen(str);
+  if (len == 0 || parse_operator(str, len, op) != len) return -1;
+  return 0;
+}
+
+/**
+ * Same as `semver_satisfies`, applying an operator decoded
+ * by `semver_op_parse`.
+ */
+
+SEMVER_API int
+semver_satisfies_op (const semver_t *x, const semver_t *y, semver_op_t op) {
+  STATS_ADD(SEMVER_STAT_SATISFIES, 1);
+
+  switch (op) {
+    case SEMVER_OP_EQ: return semver_compare_ptr(x, y) == 0;
+    case SEMVER_OP_GT: return semver_compare_ptr(x, y) > 0;
+    case SEMVER_OP_GTE: return semver_compare_ptr(x, y) >= 0;
+    case SEMVER_OP_LT: return semver_compare_ptr(x, y) < 0;
+    case SEMVER_OP_LTE: return semver_compare_ptr(x, y) <= 0;
+    case SEMVER_OP_TILDE: return semver_satisfies_patch_ptr(x, y);
+    case SEMVER_OP_CARET: return semver_satisfies_caret_ptr(x, y);
+  }
+  return 0;
+}
+
+/**
+ * Checks every version of `arr` against `y` with `semver_satisfies_op`,
+ * setting bit `i % 8` of `bitmap[i / 8]` when `arr[i]` satisfies it.
+ * `bitmap` must hold `(n + 7) / 8` bytes.
+ *
+ * Returns the number of satisfying versions.
+ */
+
+SEMVER_API size_t
+semver_satisfies_op_many (const semver_t *arr, size_t n, const semver_t *y,
+                          semver_op_t op, unsigned char *bitmap) {
+  size_t i, count;
+  unsigned char bits;
+
+  count = 0;
+  bits = 0;
+  for (i = 0; i < n; i++) {
+    if (semver_satisfies_op(&arr[i], y, op)) {
+      bits |= (unsigned char) (1 << (i & 7));
+      count++;
+    }
+    if ((i & 7) == 7) {
+      bitmap[i >> 3] = bits;
+      bits = 0;
+    }
+  }
+
+  if (n & 7) bitmap[n >> 3] = bits;
+  return count;
+}
+
+/**
+ * Free heep allocated memory of a given semver.
+ * This is just a convenient function that you
  * should call when you're done.
  */
 
-void
+SEMVER_API void
 semver_free (semver_t *x) {
   if (x->metadata) {
     free(x->metadata);
@@ -498,49 +1564,130 @@ semver_free (semver_t *x) {
  * Renders
  */
 
-static void
-concat_num (char * str, int x, char * sep) {
-  char buf[SLICE_SIZE] = {0};
-  if (sep == NULL) sprintf(buf, "%d", x);
-  else sprintf(buf, "%s%d", sep, x);
-  strcat(str, buf);
+/*
+ * Writes the decimal representation of x into buf, which must hold
+ * at least INT_DIGITS bytes, returning the written length.
+ */
+
+#define INT_DIGITS (sizeof(int) * 3 + 1)
+
+static size_t
+format_int (char *buf, int x) {
+  char tmp[INT_DIGITS];
+  unsigned int u = x < 0 ? 0u - (unsigned int) x : (unsigned int) x;
+  size_t n = 0, len = 0;
+
+  do {
+    tmp[n++] = (char) ('0' + u % 10);
+    u /= 10;
+  } while (u);
+
+  if (x < 0) buf[len++] = '-';
+  while (n) buf[len++] = tmp[--n];
+  return len;
 }
 
-static void
-concat_char (char * str, char * x, char * sep) {
-  char buf[SLICE_SIZE] = {0};
-  sprintf(buf, "%s%s", sep, x);
-  strcat(str, buf);
+/*
+ * Copies as much of src as fits at dest[pos:cap], returning the
+ * position after the full piece so callers can size the output.
+ */
+
+static size_t
+render_put (char *dest, size_t cap, size_t pos, const char *src, size_t len) {
+  if (pos < cap) memcpy(dest + pos, src, len < cap - pos ? len : cap - pos);
+  return pos + len;
+}
+
+/**
+ * Render a given semver into dest, writing at most cap bytes
+ * including the NUL terminator, like snprintf does.
+ *
+ * Returns:
+ *
+ * The length of the full rendering, excluding the NUL terminator.
+ * If it is greater than or equal to cap, the output was truncated.
+ */
+
+SEMVER_API size_t
+semver_render_n (const semver_t *x, char *dest, size_t cap) {
+  char num[3 * INT_DIGITS];
+  size_t pos = 0, len;
+
+  len = format_int(num, x->major);
+  num[len++] = DELIMITER[0];
+  len += format_int(num + len, x->minor);
+  num[len++] = DELIMITER[0];
+  len += format_int(num + len, x->patch);
+  pos = render_put(dest, cap, pos, num, len);
+
+  if (x->prerelease) {
+    pos = render_put(dest, cap, pos, PR_DELIMITER, 1);
+    pos = render_put(dest, cap, pos, x->prerelease, strlen(x->prerelease));
+  }
+
+  if (x->metadata) {
+    pos = render_put(dest, cap, pos, MT_DELIMITER, 1);
+    pos = render_put(dest, cap, pos, x->metadata, strlen(x->metadata));
+  }
+
+  if (cap) dest[pos < cap ? pos : cap - 1] = '\0';
+  return pos;
+}
+
+/**
+ * Render n versions back to back into dest as NUL terminated strings,
+ * storing the start of each one in offsets, which must hold n + 1
+ * entries: offsets[count] is the total number of bytes used.
+ * Rendering stops at the first version that does not fit.
+ *
+ * Returns:
+ *
+ * The number of rendered versions.
+ */
+
+SEMVER_API size_t
+semver_render_batch (const semver_t *arr, size_t n, char *dest, size_t cap, size_t *offsets) {
+  size_t i, len, used = 0;
+
+  for (i = 0; i < n; i++) {
+    len = semver_render_n(&arr[i], dest + used, cap - used);
+    if (len >= cap - used) {
+      if (used < cap) dest[used] = '\0';
+      break;
+    }
+    offsets[i] = used;
+    used += len + 1;
+  }
+
+  offsets[i] = used;
+  return i;
 }
 
 /**
- * Render a given semver as string
+ * Render a given semver as string, appending it to dest.
  */
 
-void
+SEMVER_API void
 semver_render (semver_t *x, char *dest) {
-  concat_num(dest, x->major, NULL);
-  concat_num(dest, x->minor, DELIMITER);
-  concat_num(dest, x->patch, DELIMITER);
-  if (x->prerelease) concat_char(dest, x->prerelease, PR_DELIMITER);
-  if (x->metadata) concat_char(dest, x->metadata, MT_DELIMITER);
+  dest += strlen(dest);
+  semver_render_n(x, dest, (size_t) -1);
 }
 
 /**
  * Version bump helpers
  */
 
-void
+SEMVER_API void
 semver_bump (semver_t *x) {
   x->major++;
 }
 
-void
+SEMVER_API void
 semver_bump_minor (semver_t *x) {
   x->minor++;
 }
 
-void
+SEMVER_API void
 semver_bump_patch (semver_t *x) {
   x->patch++;
 }
@@ -554,6 +1701,108 @@ has_valid_length (const char *s) {
   return strlen(s) <= MAX_SIZE;
 }
 
+#define is_valid_char(c) (char_class[(unsigned char) (c)] != C_OTHER)
+
+/*
+ * Validity kernels: return 1 if the `len` bytes at `s` are VALID_CHARS.
+ * The SIMD versions classify 16 (or 32) bytes per iteration using unaligned
+ * loads of full chunks only, leaving the tail to the scalar loop, so they
+ * never read past the end of the string.
+ */
+
+static int
+valid_chars_scalar (const char *s, size_t len) {
+  size_t i;
+  for (i = 0; i < len; i++)
+    if (!is_valid_char(s[i])) return 0;
+  return 1;
+}
+
+#ifdef SEMVER_SSE2
+
+#define SSE2_RANGE(v, lo, hi) \
+  _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((lo) - 1)), \
+                _mm_cmplt_epi8(v, _mm_set1_epi8((hi) + 1)))
+
+static int
+valid_chars_sse2 (const char *s, size_t len) {
+  size_t i;
+  __m128i v, ok;
+
+  for (i = 0; i + 16 <= len; i += 16) {
+    v = _mm_loadu_si128((const __m128i *) (s + i));
+    ok = _mm_or_si128(SSE2_RANGE(v, '0', '9'),
+                      SSE2_RANGE(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'));
+    ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8(DELIMITER[0])));
+    ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8(PR_DELIMITER[0])));
+    ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8(MT_DELIMITER[0])));
+    if (_mm_movemask_epi8(ok) != 0xffff) return 0;
+  }
+
+  return valid_chars_scalar(s + i, len - i);
+}
+
+#endif
+
+#ifdef SEMVER_AVX2
+
+#define AVX2_RANGE(v, lo, hi) \
+  _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8((lo) - 1)), \
+                   _mm256_cmpgt_epi8(_mm256_set1_epi8((hi) + 1), v))
+
+__attribute__((target("avx2")))
+static int
+valid_chars_avx2 (const char *s, size_t len) {
+  size_t i;
+  __m256i v, ok;
+
+  for (i = 0; i + 32 <= len; i += 32) {
+    v = _mm256_loadu_si256((const __m256i *) (s + i));
+    ok = _mm256_or_si256(AVX2_RANGE(v, '0', '9'),
+                         AVX2_RANGE(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'));
+    ok = _mm256_or_si256(ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(DELIMITER[0])));
+    ok = _mm256_or_si256(ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(PR_DELIMITER[0])));
+    ok = _mm256_or_si256(ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(MT_DELIMITER[0])));
+    if (_mm256_movemask_epi8(ok) != -1) return 0;
+  }
+
+  /* Clear the upper halves before running legacy SSE code on the tail */
+  _mm256_zeroupper();
+  return valid_chars_sse2(s + i, len - i);
+}
+
+#endif
+
+typedef int (*valid_chars_fn)(const char *, size_t);
+
+static kernel_fn
+select_valid_chars (void) {
+#ifdef SEMVER_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return (kernel_fn) valid_chars_avx2;
+#endif
+#ifdef SEMVER_SSE2
+  return (kernel_fn) valid_chars_sse2;
+#else
+  return (kernel_fn) valid_chars_scalar;
+#endif
+}
+
+static kernel_fn valid_chars = NULL;
+
+#define valid_chars_kernel() ((valid_chars_fn) kernel_get(&valid_chars, select_valid_chars))
+
+/*
+ * Bounded length check: the terminator must be found within MAX_SIZE + 1
+ * bytes, so overlong junk input is rejected without scanning all of it.
+ */
+static int
+is_valid (valid_chars_fn valid, const char *s) {
+  const char *end;
+  end = (const char *) memchr(s, '\0', MAX_SIZE + 1);
+  return end != NULL && valid(s, end - s);
+}
+
 /**
  * Checks if a given semver string is valid
  *
@@ -563,10 +1812,39 @@ has_valid_length (const char *s) {
  * `0` - Invalid
  */
 
-int
+SEMVER_API int
 semver_is_valid (const char *s) {
-  return has_valid_length(s)
-      && has_valid_chars(s, VALID_CHARS);
+  return is_valid(valid_chars_kernel(), s);
+}
+
+/**
+ * Checks a batch of `n` strings with `semver_is_valid`, setting
+ * bit `i % 8` of `bitmap[i / 8]` when `strs[i]` is valid.
+ * NULL entries are invalid. `bitmap` must hold `(n + 7) / 8` bytes.
+ *
+ * Returns the number of valid strings.
+ */
+
+SEMVER_API size_t
+semver_is_valid_batch (const char **strs, size_t n, unsigned char *bitmap) {
+  size_t i, count;
+  unsigned char bits;
+  valid_chars_fn valid = valid_chars_kernel();
+
+  count = 0;
+  bits = 0;
+  for (i = 0; i < n; i++) {
+    if (strs[i] && is_valid(valid, strs[i])) {
+      bits |= (unsigned char) (1 << (i & 7));
+      count++;
+    }
+    if ((i & 7) == 7 || i == n - 1) {
+      bitmap[i >> 3] = bits;
+      bits = 0;
+    }
+  }
+
+  return count;
 }
 
 /**
@@ -578,17 +1856,16 @@ semver_is_valid (const char *s) {
  * `-1` - Invalid input
  */
 
-int
+SEMVER_API int
 semver_clean (char *s) {
-  size_t i, len, mlen;
+  size_t i, len;
   int res;
   if (has_valid_length(s) == 0) return -1;
 
   len = strlen(s);
-  mlen = strlen(VALID_CHARS);
 
   for (i = 0; i < len; i++) {
-    if (contains(s[i], VALID_CHARS, mlen) == 0) {
+    if (!is_valid_char(s[i])) {
       res = strcut(s, i, 1);
       if(res == -1) return -1;
       --len; --i;
@@ -601,13 +1878,12 @@ semver_clean (char *s) {
 static int
 char_to_int (const char * str) {
   int buf;
-  size_t i,len, mlen;
+  size_t i, len;
   buf = 0;
   len = strlen(str);
-  mlen = strlen(VALID_CHARS);
 
   for (i = 0; i < len; i++)
-    if (contains(str[i], VALID_CHARS, mlen))
+    if (is_valid_char(str[i]))
       buf += (int) str[i];
 
   return buf;
@@ -618,15 +1894,16 @@ char_to_int (const char * str) {
  * Useful for ordering and filtering.
  */
 
-int
+SEMVER_API int
 semver_numeric (semver_t *x) {
   int num;
-  char buf[SLICE_SIZE * 3];
-  memset(&buf, 0, SLICE_SIZE * 3);
+  char buf[3 * INT_DIGITS + 1];
+  size_t len = 0;
 
-  if (x->major) concat_num(buf, x->major, NULL);
-  if (x->major || x->minor) concat_num(buf, x->minor, NULL);
-  if (x->major || x->minor || x->patch) concat_num(buf, x->patch, NULL);
+  if (x->major) len += format_int(buf + len, x->major);
+  if (x->major || x->minor) len += format_int(buf + len, x->minor);
+  if (x->major || x->minor || x->patch) len += format_int(buf + len, x->patch);
+  buf[len] = '\0';
 
   num = parse_int(buf);
   if(num == -1) return -1;
@@ -636,3 +1913,3696 @@ semver_numeric (semver_t *x) {
 
   return num;
 }
+
+/**
+ * Sort keys
+ *
+ * The prerelease rank packs the first prerelease identifier:
+ *
+ * - No prerelease: 0xffffffff, above every prerelease.
+ * - Numeric identifier: value << 1, with the top bit clear.
+ * - Alphanumeric identifier: top bit set, then its first four
+ *   characters in 7 bits each, so it ranks above numeric ones.
+ *
+ * The lowest bit is set when there are more identifiers or characters
+ * than the rank can hold. Such keys are still correctly ordered against
+ * any different key, but equal keys only prove equal precedence when
+ * both were exact.
+ */
+
+#define KEY_MASK        0xffffffffUL
+#define KEY_RELEASE     0xffffffffUL
+#define KEY_ALPHA       0x80000000UL
+#define KEY_NUMERIC_MAX 0x3ffffffeUL
+
+static int
+prerelease_rank (const char *pr, size_t len, semver_word_t *rank) {
+  size_t n, i;
+  unsigned long value;
+  unsigned int c;
+  int more;
+  if (pr == NULL) {
+    *rank = KEY_RELEASE;
+    return 1;
+  }
+
+  for (n = 0; n < len && pr[n] != DELIMITER[0]; n++);
+  more = n < len;
+
+  if (is_numeric(pr, n)) {
+    for (i = 0, value = 0; i < n; i++) {
+      value = value * 10 + (pr[i] - '0');
+      if (value > KEY_NUMERIC_MAX) {
+        *rank = (semver_word_t) ((KEY_NUMERIC_MAX << 1) | 1);
+        return 0;
+      }
+    }
+    *rank = (semver_word_t) ((value << 1) | more);
+    return !more;
+  }
+
+  value = 0;
+  for (i = 0; i < 4; i++) {
+    c = i < n ? (unsigned char) pr[i] : 0;
+    if (c > 0x7f) {
+      /* Saturate the rest of the rank: the identifier sorts after
+         every other one sharing the characters before this byte */
+      value = value << (7 * (4 - i)) | ((1UL << (7 * (4 - i))) - 1);
+      more = 1;
+      break;
+    }
+    value = value << 7 | c;
+  }
+  more = more || n > 4;
+  *rank = (semver_word_t) (KEY_ALPHA | (value << 2) | more);
+  return !more;
+}
+
+static int
+make_key (unsigned long major, unsigned long minor, unsigned long patch,
+          const char *pr, size_t len, semver_key_t *key) {
+  key->w[0] = (semver_word_t) (major & KEY_MASK);
+  key->w[1] = (semver_word_t) (minor & KEY_MASK);
+  key->w[2] = (semver_word_t) (patch & KEY_MASK);
+  return prerelease_rank(pr, len, &key->w[3]);
+}
+
+/**
+ * Builds the packed sort key of a given semver. Build metadata
+ * is ignored, as it does not take part in precedence.
+ *
+ * Returns:
+ *
+ * `1` - Exact key: equal exact keys mean equal versions
+ * `0` - Ties with an equal key must be resolved with `semver_compare`
+ * `-1` - Negative component, which keys cannot order
+ */
+
+SEMVER_API int
+semver_key (const semver_t *x, semver_key_t *key) {
+  int exact = make_key(x->major, x->minor, x->patch,
+                       x->prerelease, x->prerelease ? strlen(x->prerelease) : 0, key);
+  return (x->major | x->minor | x->patch) < 0 ? -1 : exact;
+}
+
+/**
+ * Same as `semver_key` for borrowed version views.
+ */
+
+SEMVER_API int
+semver_view_key (const semver_view_t *x, semver_key_t *key) {
+  int exact = make_key(x->major, x->minor, x->patch,
+                       x->prerelease.len ? x->src + x->prerelease.offset : NULL,
+                       x->prerelease.len, key);
+  return (x->major | x->minor | x->patch) < 0 ? -1 : exact;
+}
+
+/**
+ * Compare two sort keys.
+ *
+ * Returns:
+ * - `1` if x is higher than y
+ * - `0` if x is equal to y
+ * - `-1` if x is lower than y
+ */
+
+SEMVER_API int
+semver_key_compare (const semver_key_t *x, const semver_key_t *y) {
+  int i;
+  for (i = 0; i < 4; i++)
+    if (x->w[i] != y->w[i]) return x->w[i] < y->w[i] ? -1 : 1;
+  return 0;
+}
+
+/**
+ * Sorting
+ *
+ * Keys are ordered with a stable LSD radix sort over their 16 bytes.
+ * Byte positions holding the same value for every key are skipped, so
+ * typical corpora only need a handful of passes. Runs of equal inexact
+ * keys are then ordered with `semver_compare`.
+ */
+
+#define RADIX_PASSES 16
+
+static int
+key_exact (const semver_key_t *key) {
+  return key->w[3] == KEY_RELEASE || !(key->w[3] & 1);
+}
+
+static int
+radix_sort (semver_key_t *keys, size_t *perm, size_t n) {
+  semver_key_t *tkeys, *skeys, *dkeys, *swapk;
+  size_t *tperm, *sperm, *dperm, *swapp;
+  size_t counts[256];
+  size_t i, sum, c;
+  semver_word_t diff[4];
+  int pass, word, shift;
+
+  if (n < 2) return 0;
+
+  /* Find the bytes that differ between keys, every other pass is a no-op */
+  diff[0] = diff[1] = diff[2] = diff[3] = 0;
+  for (i = 1; i < n; i++) {
+    diff[0] |= keys[i].w[0] ^ keys[0].w[0];
+    diff[1] |= keys[i].w[1] ^ keys[0].w[1];
+    diff[2] |= keys[i].w[2] ^ keys[0].w[2];
+    diff[3] |= keys[i].w[3] ^ keys[0].w[3];
+  }
+  if (!(diff[0] | diff[1] | diff[2] | diff[3])) return 0;
+
+  tkeys = (semver_key_t*)mem_alloc(n * sizeof(*tkeys));
+  tperm = (size_t*)mem_alloc(n * sizeof(*tperm));
+  if (tkeys == NULL || tperm == NULL) {
+    free(tkeys);
+    free(tperm);
+    return -1;
+  }
+
+  skeys = keys; sperm = perm;
+  dkeys = tkeys; dperm = tperm;
+
+  for (pass = 0; pass < RADIX_PASSES; pass++) {
+    word = 3 - pass / 4;
+    shift = (pass % 4) * 8;
+    if (!((diff[word] >> shift) & 0xff)) continue;
+
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < n; i++)
+      counts[(skeys[i].w[word] >> shift) & 0xff]++;
+
+    for (i = 0, sum = 0; i < 256; i++) {
+      c = counts[i];
+      counts[i] = sum;
+      sum += c;
+    }
+
+    for (i = 0; i < n; i++) {
+      c = counts[(skeys[i].w[word] >> shift) & 0xff]++;
+      dkeys[c] = skeys[i];
+      dperm[c] = sperm[i];
+    }
+
+    swapk = skeys; skeys = dkeys; dkeys = swapk;
+    swapp = sperm; sperm = dperm; dperm = swapp;
+  }
+
+  if (skeys != keys) {
+    memcpy(keys, skeys, n * sizeof(*keys));
+    memcpy(perm, sperm, n * sizeof(*perm));
+  }
+
+  free(tkeys);
+  free(tperm);
+  return 0;
+}
+
+/*
+ * Orders arr[0..n) with `semver_compare`,
+ * insertion sort for the short runs expected from key ties.
+ */
+static void
+compare_sort (semver_t *arr, size_t n) {
+  semver_t tmp;
+  size_t i, j;
+  if (n > 16) {
+    qsort(arr, n, sizeof(*arr), semver_compare_asc);
+    return;
+  }
+  for (i = 1; i < n; i++) {
+    tmp = arr[i];
+    for (j = i; j > 0 && semver_compare_ptr(&arr[j - 1], &tmp) > 0; j--)
+      arr[j] = arr[j - 1];
+    arr[j] = tmp;
+  }
+}
+
+/**
+ * Sorts an array of packed keys in ascending order.
+ * If `perm` is not NULL, it receives the original position of every
+ * sorted key. Equal keys keep their original relative order, so
+ * inexact ties (see `semver_key`) are not resolved.
+ *
+ * Returns:
+ *
+ * `0` - Sorted
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_key_sort (semver_key_t *keys, size_t *perm, size_t n) {
+  size_t *tmp, i;
+  int res;
+  tmp = perm ? perm : (size_t*)mem_alloc(n * sizeof(*tmp));
+  if (tmp == NULL && n) return -1;
+
+  for (i = 0; i < n; i++) tmp[i] = i;
+  res = radix_sort(keys, tmp, n);
+
+  if (perm == NULL) free(tmp);
+  return res;
+}
+
+/**
+ * Sorts an array of semver in ascending `semver_compare` order.
+ * Versions with negative components are not supported.
+ *
+ * Returns:
+ *
+ * `0` - Sorted
+ * `-1` - Memory allocation error or negative component, `arr` is unchanged
+ */
+
+SEMVER_API int
+semver_sort (semver_t *arr, size_t n) {
+  semver_key_t *keys;
+  semver_t *sorted;
+  size_t *perm, i, j;
+  int res;
+
+  if (n < 2) return 0;
+
+  keys = (semver_key_t*)mem_alloc(n * sizeof(*keys));
+  perm = (size_t*)mem_alloc(n * sizeof(*perm));
+  sorted = (semver_t*)mem_alloc(n * sizeof(*sorted));
+  res = -1;
+
+  if (keys && perm && sorted) {
+    for (i = 0; i < n; i++) {
+      if (semver_key(&arr[i], &keys[i]) < 0) break;
+      perm[i] = i;
+    }
+    if (i == n) res = radix_sort(keys, perm, n);
+  }
+
+  if (res == 0) {
+    for (i = 0; i < n; i++) sorted[i] = arr[perm[i]];
+    memcpy(arr, sorted, n * sizeof(*arr));
+
+    for (i = 0; i < n; i = j) {
+      for (j = i + 1; j < n && semver_key_compare(&keys[i], &keys[j]) == 0; j++);
+      if (j - i > 1 && !key_exact(&keys[i])) compare_sort(arr + i, j - i);
+    }
+  }
+
+  free(keys);
+  free(perm);
+  free(sorted);
+  return res;
+}
+
+/*
+ * Sifts down the run at heap[i] of a binary min-heap of runs, ordered
+ * by their current head and then by run number, so merges are stable.
+ */
+
+static void
+merge_sift (size_t *heap, size_t len, size_t i, const size_t *pos, const semver_t *arr) {
+  size_t c, r = heap[i];
+  int cmp;
+
+  while ((c = 2 * i + 1) < len) {
+    if (c + 1 < len) {
+      cmp = semver_compare_ptr(&arr[pos[heap[c + 1]]], &arr[pos[heap[c]]]);
+      if (cmp < 0 || (cmp == 0 && heap[c + 1] < heap[c])) c++;
+    }
+    cmp = semver_compare_ptr(&arr[pos[heap[c]]], &arr[pos[r]]);
+    if (cmp > 0 || (cmp == 0 && heap[c] > r)) break;
+    heap[i] = heap[c];
+    i = c;
+  }
+
+  heap[i] = r;
+}
+
+/*
+ * Merges the sorted runs `arr[pos[r]:end[r]]` into `out`, advancing
+ * `pos`, with a `heap` of `runs` items. Returns the number merged.
+ */
+
+static size_t
+merge_runs (const semver_t *arr, size_t *pos, const size_t *end, size_t runs,
+            size_t *heap, size_t *out) {
+  size_t len, r, i;
+
+  for (r = 0, len = 0; r < runs; r++) {
+    if (pos[r] < end[r]) heap[len++] = r;
+  }
+
+  for (i = len / 2; i > 0; i--) merge_sift(heap, len, i - 1, pos, arr);
+
+  for (i = 0; len > 0; i++) {
+    r = heap[0];
+    out[i] = pos[r]++;
+    if (pos[r] == end[r]) heap[0] = heap[--len];
+    merge_sift(heap, len, 0, pos, arr);
+  }
+
+  return i;
+}
+
+/**
+ * Merges `runs` sorted runs stored back to back in `arr`, run `r` being
+ * `arr[bounds[r]:bounds[r + 1]]`, writing in `out` the position in `arr`
+ * of every version in ascending `semver_compare` order. Equal versions
+ * keep their run and position order, so the result does not depend on
+ * the order the runs were produced in.
+ *
+ * This is the last step of a parallel bulk sort: every thread parses and
+ * sorts one chunk (`semver_parse_batch` and `semver_sort`), then a single
+ * merge gives the global order (see `semver_parse_sort_parallel`).
+ *
+ * Returns:
+ *
+ * `0` - Merged
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_merge (const semver_t *arr, const size_t *bounds, size_t runs, size_t *out) {
+  size_t *heap, *pos, r;
+
+  if (runs == 0) return 0;
+  heap = (size_t*)mem_alloc(2 * runs * sizeof(*heap));
+  if (heap == NULL) return -1;
+  pos = heap + runs;
+
+  for (r = 0; r < runs; r++) pos[r] = bounds[r];
+  merge_runs(arr, pos, bounds + 1, runs, heap, out);
+
+  free(heap);
+  return 0;
+}
+
+#ifdef SEMVER_THREADS
+
+/*
+ * Parallel parse and sort
+ *
+ * The input is cut in chunks of SEMVER_PARALLEL_CHUNK strings, claimed
+ * one at a time from a shared counter so fast threads take over the
+ * work of slow ones. Every chunk is parsed and sorted into a run of its
+ * own. The merge is split the same way: versions sampled from the runs
+ * cut the value space into one segment per chunk, and every segment is
+ * merged on its own into its place in the output. Cuts fall between
+ * different versions, so this gives exactly the order of a single
+ * `semver_merge`. Neither the chunks nor the segments depend on the
+ * number of threads, so neither does the result.
+ */
+
+#ifndef SEMVER_PARALLEL_CHUNK
+#define SEMVER_PARALLEL_CHUNK 4096
+#endif
+
+/* Versions sampled from every run to pick the segment bounds */
+#define PARALLEL_SAMPLES 8
+
+struct parallel_job {
+  const char **strs;
+  size_t n;
+  size_t chunks;
+  size_t next;
+  int (*fn) (struct parallel_job *job, size_t item);
+  int *res;
+  semver_t *tmp;
+  int *status;
+  char **blocks;
+  size_t *valid;
+  size_t *size;
+  semver_t *samples;
+  size_t nsamples;
+  char *block;
+  size_t *order;
+  semver_t *out;
+#ifndef __ATOMIC_RELAXED
+  pthread_mutex_t lock;
+#endif
+};
+
+static size_t
+parallel_claim (struct parallel_job *job) {
+#ifdef __ATOMIC_RELAXED
+  return __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+#else
+  size_t c;
+  pthread_mutex_lock(&job->lock);
+  c = job->next++;
+  pthread_mutex_unlock(&job->lock);
+  return c;
+#endif
+}
+
+static void *
+parallel_worker (void *data) {
+  struct parallel_job *job = (struct parallel_job *) data;
+  size_t c;
+
+  while ((c = parallel_claim(job)) < job->chunks) {
+    job->res[c] = job->fn(job, c);
+  }
+  return NULL;
+}
+
+/*
+ * Runs `fn` over every chunk on up to `threads` threads, the calling
+ * one included. Threads failing to start only leave more work to the
+ * others.
+ */
+
+static int
+parallel_run (struct parallel_job *job, pthread_t *workers, size_t threads,
+              int (*fn) (struct parallel_job *job, size_t item)) {
+  size_t started, c;
+
+  job->fn = fn;
+  job->next = 0;
+  for (started = 0; started + 1 < threads; started++) {
+    if (pthread_create(&workers[started], NULL, parallel_worker, job)) break;
+  }
+  parallel_worker(job);
+  while (started > 0) pthread_join(workers[--started], NULL);
+
+  for (c = 0; c < job->chunks; c++) {
+    if (job->res[c]) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Parses a chunk, moves its valid versions to the front and sorts
+ * them, recording their number and the size of their strings.
+ */
+
+static int
+parallel_sort_chunk (struct parallel_job *job, size_t c) {
+  size_t off, len, i, j, size;
+  semver_t *arr;
+
+  off = c * SEMVER_PARALLEL_CHUNK;
+  len = job->n - off < SEMVER_PARALLEL_CHUNK ? job->n - off : SEMVER_PARALLEL_CHUNK;
+  arr = job->tmp + off;
+  if (semver_parse_batch(job->strs + off, len, arr, job->status + off, &job->blocks[c]))
+    return -1;
+
+  for (i = 0, j = 0, size = 0; i < len; i++) {
+    if (job->status[off + i]) continue;
+    arr[j] = arr[i];
+    if (arr[j].prerelease) size += strlen(arr[j].prerelease) + 1;
+    if (arr[j].metadata) size += strlen(arr[j].metadata) + 1;
+    j++;
+  }
+
+  job->valid[c] = j;
+  job->size[c] = size;
+  return semver_sort(arr, j);
+}
+
+/* First position of a sorted run holding a version not below `ver` */
+static size_t
+parallel_lower_bound (const semver_t *arr, size_t lo, size_t hi, const semver_t *ver) {
+  size_t mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (semver_compare_ptr(&arr[mid], ver) < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+/*
+ * Merges the versions of segment `k` into the output, rebasing their
+ * strings onto the final block, and moves the strings of chunk `k`
+ * there. `size` holds the offsets of the chunks in the block by now.
+ */
+
+static int
+parallel_merge_segment (struct parallel_job *job, size_t k) {
+  const semver_t *lo, *hi;
+  size_t *heap, *pos, *end, r, first, off, len, i, c;
+  semver_t *ver;
+
+  if (job->blocks[k]) {
+    memcpy(job->block + job->size[k], job->blocks[k], job->size[k + 1] - job->size[k]);
+  }
+
+  heap = (size_t*)mem_alloc(3 * job->chunks * sizeof(*heap));
+  if (heap == NULL) return -1;
+  pos = heap + job->chunks;
+  end = pos + job->chunks;
+
+  lo = k ? &job->samples[k * job->nsamples / job->chunks] : NULL;
+  hi = k + 1 < job->chunks ? &job->samples[(k + 1) * job->nsamples / job->chunks] : NULL;
+  for (r = 0, off = 0; r < job->chunks; r++) {
+    first = r * SEMVER_PARALLEL_CHUNK;
+    end[r] = first + job->valid[r];
+    pos[r] = lo ? parallel_lower_bound(job->tmp, first, end[r], lo) : first;
+    if (hi) end[r] = parallel_lower_bound(job->tmp, pos[r], end[r], hi);
+    off += pos[r] - first;
+  }
+
+  len = merge_runs(job->tmp, pos, end, job->chunks, heap, job->order + off);
+  for (i = off; i < off + len; i++) {
+    ver = &job->out[i];
+    *ver = job->tmp[job->order[i]];
+    c = job->order[i] / SEMVER_PARALLEL_CHUNK;
+    if (ver->prerelease) ver->prerelease = job->block + job->size[c] + (ver->prerelease - job->blocks[c]);
+    if (ver->metadata) ver->metadata = job->block + job->size[c] + (ver->metadata - job->blocks[c]);
+  }
+
+  free(heap);
+  return 0;
+}
+
+/*
+ * Turns the string sizes of the chunks into their offsets in the final
+ * block, allocates it and samples the runs, returning the number of
+ * valid versions.
+ */
+
+static int
+parallel_prepare (struct parallel_job *job, size_t *count) {
+  size_t c, i, total, size;
+
+  for (c = 0, total = 0, *count = 0; c < job->chunks; c++) {
+    size = job->size[c];
+    job->size[c] = total;
+    total += size;
+    *count += job->valid[c];
+  }
+  job->size[job->chunks] = total;
+
+  if (total) {
+    job->block = (char*)mem_alloc(total);
+    if (job->block == NULL) return -1;
+  }
+
+  job->nsamples = 0;
+  for (c = 0; c < job->chunks; c++) {
+    for (i = 0; i < PARALLEL_SAMPLES && i < job->valid[c]; i++) {
+      job->samples[job->nsamples++] =
+        job->tmp[c * SEMVER_PARALLEL_CHUNK + i * job->valid[c] / PARALLEL_SAMPLES];
+    }
+  }
+  return semver_sort(job->samples, job->nsamples);
+}
+
+/**
+ * Parses an array of `n` strings and sorts them in ascending
+ * `semver_compare` order, using up to `threads` threads (the calling
+ * one included). The `*count` valid versions are written to the caller
+ * owned `out` array, invalid strings being skipped.
+ *
+ * As in `semver_parse_batch`, prerelease and metadata strings are
+ * stored in a single block returned in `block` (NULL if there are
+ * none), released with one `free(*block)`. The result, including the
+ * order of versions comparing equal, is the same for any number of
+ * threads.
+ *
+ * Returns:
+ *
+ * `0` - Parsed and sorted
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_parse_sort_parallel (const char **strs, size_t n, size_t threads,
+                            semver_t *out, size_t *count, char **block) {
+  struct parallel_job job;
+  pthread_t *workers;
+  size_t c, valid;
+  int res;
+
+  *count = 0;
+  *block = NULL;
+  if (n == 0) return 0;
+
+  memset(&job, 0, sizeof(job));
+  job.strs = strs;
+  job.n = n;
+  job.out = out;
+  job.chunks = n / SEMVER_PARALLEL_CHUNK + (n % SEMVER_PARALLEL_CHUNK != 0);
+  if (threads == 0) threads = 1;
+  if (threads > job.chunks) threads = job.chunks;
+
+  job.res = (int*)mem_alloc(job.chunks * sizeof(*job.res));
+  job.tmp = (semver_t*)mem_alloc(n * sizeof(*job.tmp));
+  job.status = (int*)mem_alloc(n * sizeof(*job.status));
+  job.blocks = (char**)mem_calloc(job.chunks, sizeof(*job.blocks));
+  job.valid = (size_t*)mem_alloc(job.chunks * sizeof(*job.valid));
+  job.size = (size_t*)mem_alloc((job.chunks + 1) * sizeof(*job.size));
+  job.samples = (semver_t*)mem_alloc(job.chunks * PARALLEL_SAMPLES * sizeof(*job.samples));
+  job.order = (size_t*)mem_alloc(n * sizeof(*job.order));
+  workers = (pthread_t*)mem_alloc(threads * sizeof(*workers));
+  res = -1;
+
+  if (job.res && job.tmp && job.status && job.blocks && job.valid && job.size
+      && job.samples && job.order && workers) {
+#ifndef __ATOMIC_RELAXED
+    pthread_mutex_init(&job.lock, NULL);
+#endif
+    if (parallel_run(&job, workers, threads, parallel_sort_chunk) == 0
+        && parallel_prepare(&job, &valid) == 0) {
+      if (valid == 0 || parallel_run(&job, workers, threads, parallel_merge_segment) == 0) {
+        *count = valid;
+        *block = job.block;
+        job.block = NULL;
+        res = 0;
+      }
+    }
+#ifndef __ATOMIC_RELAXED
+    pthread_mutex_destroy(&job.lock);
+#endif
+  }
+
+  if (job.blocks) {
+    for (c = 0; c < job.chunks; c++) free(job.blocks[c]);
+  }
+  free(job.block);
+  free(job.res);
+  free(job.tmp);
+  free(job.status);
+  free(job.blocks);
+  free(job.valid);
+  free(job.size);
+  free(job.samples);
+  free(job.order);
+  free(workers);
+  return res;
+}
+
+#endif
+
+/**
+ * Ranges
+ *
+ * A range expression is compiled into a sorted set of disjoint
+ * intervals over packed keys. Every comparator set (the expressions
+ * between `||`) is the intersection of the intervals of its comparators,
+ * following the npm desugaring rules:
+ *
+ * - `1.2.3 - 2.3`  := `>=1.2.3 <2.4.0-0`
+ * - `1.x`, `1`     := `>=1.0.0 <2.0.0-0`
+ * - `~1.2.3`       := `>=1.2.3 <1.3.0-0`
+ * - `^1.2.3`       := `>=1.2.3 <2.0.0-0`
+ * - `^0.2.3`       := `>=0.2.3 <0.3.0-0`
+ * - `^0.0.3`       := `>=0.0.3 <0.0.4-0`
+ * - `>1.2`         := `>=1.3.0`
+ * - `<=1.2`        := `<1.3.0-0`
+ *
+ * Prerelease versions are matched by plain precedence against the
+ * interval bounds, like `semver_satisfies` does.
+ */
+
+/* Prerelease of the lowest version with a given major.minor.patch */
+static const char LOWEST_PRERELEASE[] = "0";
+
+struct partial {
+  unsigned long v[3];
+  int level;
+  const char *pr;
+  size_t prlen;
+};
+
+static int
+is_space (const char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int
+is_wildcard (const char c) {
+  return c == 'x' || c == 'X' || c == '*';
+}
+
+static void
+set_bound (semver_bound_t *b, unsigned long major, unsigned long minor, unsigned long patch,
+           const char *pr, size_t prlen, int inclusive) {
+  b->exact = make_key(major, minor, patch, pr, prlen, &b->key);
+  b->prerelease = pr;
+  b->prerelease_len = prlen;
+  b->inclusive = inclusive;
+}
+
+static void
+set_unbounded (semver_interval_t *c) {
+  set_bound(&c->lo, 0, 0, 0, LOWEST_PRERELEASE, 1, 1);
+  set_bound(&c->hi, KEY_MASK, KEY_MASK, KEY_MASK, NULL, 0, 0);
+}
+
+/*
+ * Compares the version given by a key (and its prerelease, needed
+ * when the key is inexact) with the version at a bound.
+ */
+static int
+bound_compare (const semver_key_t *key, int exact, const char *pr, size_t prlen,
+               const semver_bound_t *b) {
+  int res;
+  if ((res = semver_key_compare(key, &b->key)) || (exact && b->exact)) return res;
+  return compare_prerelease_n(pr, prlen, b->prerelease, b->prerelease_len);
+}
+
+#define bound_point_compare(a, b) \
+  bound_compare(&(a)->key, (a)->exact, (a)->prerelease, (a)->prerelease_len, (b))
+
+/* Order of lower bounds: an exclusive bound starts after an inclusive one */
+static int
+lower_compare (const semver_bound_t *a, const semver_bound_t *b) {
+  int res;
+  if ((res = bound_point_compare(a, b))) return res;
+  return b->inclusive - a->inclusive;
+}
+
+/* Order of upper bounds: an exclusive bound ends before an inclusive one */
+static int
+upper_compare (const semver_bound_t *a, const semver_bound_t *b) {
+  int res;
+  if ((res = bound_point_compare(a, b))) return res;
+  return a->inclusive - b->inclusive;
+}
+
+static int
+interval_empty (const semver_interval_t *c) {
+  int res = bound_point_compare(&c->lo, &c->hi);
+  return res > 0 || (res == 0 && !(c->lo.inclusive && c->hi.inclusive));
+}
+
+/*
+ * Returns 1 if a bound prerelease ends with a `.0` identifier, which
+ * makes it the first version following the rest of the prerelease.
+ */
+static int
+bound_next_prerelease (const semver_bound_t *b) {
+  size_t len = b->prerelease_len;
+  return b->prerelease && len > 2 && b->prerelease[len - 1] == '0' && b->prerelease[len - 2] == '.';
+}
+
+/*
+ * Rewrites the bounds of an interval in a canonical form, so the same
+ * versions always give the same bounds. Nothing sorts between a release
+ * and the lowest prerelease of the next patch, nor between a prerelease
+ * and itself followed by `.0`: `>1.2.3` is stored as `>=1.2.4-0`,
+ * `<=1.2.3` as `<1.2.4-0`, `>=1.2.3-beta.0` as `>1.2.3-beta` and
+ * `<1.2.3-beta.0` as `<=1.2.3-beta`. This also makes intervals like
+ * `>1.2.3 <1.2.4-0` empty.
+ */
+static void
+interval_normalize (semver_interval_t *c) {
+  semver_bound_t *b;
+
+  b = &c->lo;
+  if (!b->inclusive && b->key.w[3] == KEY_RELEASE && b->key.w[2] != KEY_MASK)
+    set_bound(b, b->key.w[0], b->key.w[1], b->key.w[2] + 1, LOWEST_PRERELEASE, 1, 1);
+  else if (b->inclusive && bound_next_prerelease(b))
+    set_bound(b, b->key.w[0], b->key.w[1], b->key.w[2], b->prerelease, b->prerelease_len - 2, 0);
+
+  b = &c->hi;
+  if (b->inclusive && b->key.w[3] == KEY_RELEASE && b->key.w[2] != KEY_MASK)
+    set_bound(b, b->key.w[0], b->key.w[1], b->key.w[2] + 1, LOWEST_PRERELEASE, 1, 0);
+  else if (!b->inclusive && bound_next_prerelease(b))
+    set_bound(b, b->key.w[0], b->key.w[1], b->key.w[2], b->prerelease, b->prerelease_len - 2, 1);
+}
+
+static void
+interval_intersect (semver_interval_t *c, const semver_interval_t *other) {
+  if (lower_compare(&other->lo, &c->lo) > 0) c->lo = other->lo;
+  if (upper_compare(&other->hi, &c->hi) < 0) c->hi = other->hi;
+}
+
+/*
+ * Parses a partial version (`1`, `1.x`, `1.2.*`, `v1.2.3-beta`) where missing
+ * or wildcard components are recorded by the number of leading numeric ones.
+ */
+static int
+parse_partial (const char *s, size_t len, struct partial *p) {
+  semver_view_t view;
+  size_t i, start;
+  int index, digit;
+
+  p->v[0] = p->v[1] = p->v[2] = 0;
+  p->level = 3;
+  p->pr = NULL;
+  p->prlen = 0;
+
+  i = 0;
+  if (i < len && (s[i] == 'v' || s[i] == 'V')) { s++; len--; }
+
+  for (index = 0; index < 3; index++) {
+    if (i < len && is_wildcard(s[i])) {
+      if (p->level > index) p->level = index;
+      i++;
+    } else {
+      start = i;
+      while (i < len && s[i] >= '0' && s[i] <= '9') {
+        digit = s[i++] - '0';
+        if (p->v[index] > (unsigned long) (MAX_SAFE_INT - digit) / 10) return -1;
+        p->v[index] = p->v[index] * 10 + digit;
+      }
+      if (i == start || (s[start] == '0' && i - start > 1)) return -1;
+      if (p->level < index) p->v[index] = 0;
+    }
+
+    if (i == len || s[i] != DELIMITER[0] || index == 2) break;
+    i++;
+  }
+
+  if (index < 2 && p->level > index + 1) p->level = index + 1;
+  if (i == len) return 0;
+
+  /* Prerelease and build metadata require a full version */
+  if (p->level < 3 || semver_parse_view(s, len, &view)) return -1;
+  if (view.prerelease.len) {
+    p->pr = s + view.prerelease.offset;
+    p->prlen = view.prerelease.len;
+  }
+  return 0;
+}
+
+/*
+ * Desugars a single comparator into an interval.
+ * Returns 1 if no version can satisfy it.
+ */
+static int
+comparator_interval (semver_op_t op, const struct partial *p, semver_interval_t *c) {
+  unsigned long major, minor, patch;
+  major = p->v[0];
+  minor = p->v[1];
+  patch = p->v[2];
+  set_unbounded(c);
+
+  /* `*`, `>=*`, `<=*`... match any version, `>*` and `<*` none */
+  if (p->level == 0) return op == SEMVER_OP_GT || op == SEMVER_OP_LT;
+
+  switch (op) {
+    case SEMVER_OP_GT:
+      if (p->level == 1) set_bound(&c->lo, major + 1, 0, 0, NULL, 0, 1);
+      else if (p->level == 2) set_bound(&c->lo, major, minor + 1, 0, NULL, 0, 1);
+      else set_bound(&c->lo, major, minor, patch, p->pr, p->prlen, 0);
+      return 0;
+
+    case SEMVER_OP_GTE:
+      set_bound(&c->lo, major, minor, patch, p->pr, p->prlen, 1);
+      return 0;
+
+    case SEMVER_OP_LT:
+      if (p->level < 3) set_bound(&c->hi, major, minor, 0, LOWEST_PRERELEASE, 1, 0);
+      else set_bound(&c->hi, major, minor, patch, p->pr, p->prlen, 0);
+      return 0;
+
+    case SEMVER_OP_LTE:
+      if (p->level == 1) set_bound(&c->hi, major + 1, 0, 0, LOWEST_PRERELEASE, 1, 0);
+      else if (p->level == 2) set_bound(&c->hi, major, minor + 1, 0, LOWEST_PRERELEASE, 1, 0);
+      else set_bound(&c->hi, major, minor, patch, p->pr, p->prlen, 1);
+      return 0;
+
+    case SEMVER_OP_TILDE:
+      set_bound(&c->lo, major, minor, patch, p->pr, p->prlen, 1);
+      if (p->level == 1) set_bound(&c->hi, major + 1, 0, 0, LOWEST_PRERELEASE, 1, 0);
+      else set_bound(&c->hi, major, minor + 1, 0, LOWEST_PRERELEASE, 1, 0);
+      return 0;
+
+    case SEMVER_OP_CARET:
+      set_bound(&c->lo, major, minor, patch, p->pr, p->prlen, 1);
+      if (major > 0 || p->level == 1)
+        set_bound(&c->hi, major + 1, 0, 0, LOWEST_PRERELEASE, 1, 0);
+      else if (minor > 0 || p->level == 2)
+        set_bound(&c->hi, 0, minor + 1, 0, LOWEST_PRERELEASE, 1, 0);
+      else
+        set_bound(&c->hi, 0, 0, patch + 1, LOWEST_PRERELEASE, 1, 0);
+      return 0;
+
+    default:
+      set_bound(&c->lo, major, minor, patch, p->pr, p->prlen, 1);
+      if (p->level == 1) set_bound(&c->hi, major + 1, 0, 0, LOWEST_PRERELEASE, 1, 0);
+      else if (p->level == 2) set_bound(&c->hi, major, minor + 1, 0, LOWEST_PRERELEASE, 1, 0);
+      else set_bound(&c->hi, major, minor, patch, p->pr, p->prlen, 1);
+      return 0;
+  }
+}
+
+static int
+next_token (const char *s, size_t len, size_t *pos, const char **tok, size_t *tlen) {
+  size_t i = *pos;
+  while (i < len && is_space(s[i])) i++;
+  if (i == len) return 0;
+  *tok = s + i;
+  while (i < len && !is_space(s[i])) i++;
+  *tlen = i - (*tok - s);
+  *pos = i;
+  return 1;
+}
+
+/*
+ * Compiles a comparator set (`>=1.2.3 <2`, `1.2 - 1.4`) into one interval.
+ * Returns -1 on syntax errors.
+ */
+static int
+compile_set (const char *s, size_t len, semver_interval_t *set) {
+  semver_interval_t c;
+  struct partial p, q;
+  const char *tok, *next, *last;
+  size_t tlen, nlen, llen, pos, oplen;
+  int have, have_next, empty;
+  semver_op_t op;
+
+  set_unbounded(set);
+  empty = 0;
+  pos = 0;
+  have = next_token(s, len, &pos, &tok, &tlen);
+
+  while (have) {
+    have_next = next_token(s, len, &pos, &next, &nlen);
+
+    /* Hyphen range */
+    if (have_next && nlen == 1 && next[0] == PR_DELIMITER[0]) {
+      if (!next_token(s, len, &pos, &last, &llen)) return -1;
+      if (parse_partial(tok, tlen, &p) || parse_partial(last, llen, &q)) return -1;
+      if (comparator_interval(SEMVER_OP_GTE, &p, &c)) empty = 1;
+      interval_intersect(set, &c);
+      if (comparator_interval(SEMVER_OP_LTE, &q, &c)) empty = 1;
+      interval_intersect(set, &c);
+      have = next_token(s, len, &pos, &tok, &tlen);
+      continue;
+    }
+
+    oplen = parse_operator(tok, tlen, &op);
+    if (oplen == tlen) {
+      /* Operator separated from its version by whitespace */
+      if (!have_next) return -1;
+      if (parse_partial(next, nlen, &p)) return -1;
+      have_next = next_token(s, len, &pos, &next, &nlen);
+    } else if (parse_partial(tok + oplen, tlen - oplen, &p)) {
+      return -1;
+    }
+
+    if (comparator_interval(op, &p, &c)) empty = 1;
+    interval_intersect(set, &c);
+
+    tok = next;
+    tlen = nlen;
+    have = have_next;
+  }
+
+  interval_normalize(set);
+  return empty || interval_empty(set);
+}
+
+/*
+ * Merges overlapping or adjacent intervals, sorted by lower bound,
+ * in place. Returns the number of intervals left.
+ */
+static size_t
+range_merge (semver_interval_t *intervals, size_t n) {
+  semver_interval_t tmp;
+  size_t i, j;
+  int res;
+
+  for (i = 0, j = 0; i < n; i++) {
+    if (j > 0) {
+      res = bound_point_compare(&intervals[i].lo, &intervals[j - 1].hi);
+      if (res < 0 || (res == 0 && (intervals[i].lo.inclusive || intervals[j - 1].hi.inclusive))) {
+        if (upper_compare(&intervals[i].hi, &intervals[j - 1].hi) > 0)
+          intervals[j - 1].hi = intervals[i].hi;
+        continue;
+      }
+    }
+    tmp = intervals[i];
+    intervals[j++] = tmp;
+  }
+
+  return j;
+}
+
+/**
+ * Compiles a range expression, using the npm range grammar:
+ * comparator sets joined by `||`, each made of space separated
+ * comparators (`=`, `>`, `>=`, `<`, `<=`, `~`, `^`), partial and
+ * X-ranges (`1.x`, `1.2.*`) or hyphen ranges (`1.2.3 - 2.3.4`).
+ *
+ * Release the compiled range with `semver_range_free`.
+ *
+ * Returns:
+ *
+ * `0` - Compiled successfully
+ * `-1` - Syntax or memory allocation error
+ */
+
+SEMVER_API int
+semver_range_compile (const char *str, semver_range_t *range) {
+  semver_interval_t *intervals, set;
+  size_t len, sets, i, j, n, start;
+  char *src;
+  int res;
+
+  len = strlen(str);
+  for (i = 0, sets = 1; i + 1 < len; i++)
+    if (str[i] == '|' && str[i + 1] == '|') sets++;
+
+  src = (char*)mem_alloc(len + 1);
+  intervals = (semver_interval_t*)mem_alloc(sets * sizeof(*intervals));
+  if (src == NULL || intervals == NULL) {
+    free(src);
+    free(intervals);
+    return -1;
+  }
+  memcpy(src, str, len + 1);
+
+  n = 0;
+  start = 0;
+  for (i = 0; i <= len; i++) {
+    if (i < len && !(src[i] == '|' && i + 1 < len && src[i + 1] == '|')) continue;
+
+    res = compile_set(src + start, i - start, &set);
+    if (res == -1) {
+      free(src);
+      free(intervals);
+      return -1;
+    }
+    if (res == 0) {
+      /* Insert keeping the intervals ordered by lower bound */
+      for (j = n++; j > 0 && lower_compare(&set.lo, &intervals[j - 1].lo) < 0; j--)
+        intervals[j] = intervals[j - 1];
+      intervals[j] = set;
+    }
+
+    start = ++i + 1;
+  }
+
+  range->intervals = intervals;
+  range->len = range_merge(intervals, n);
+  range->src = src;
+  return 0;
+}
+
+static int
+range_match_key (const semver_range_t *range, const semver_key_t *key, int exact,
+                 const char *pr, size_t prlen) {
+  const semver_interval_t *c;
+  size_t i;
+  int res;
+
+  STATS_ADD(SEMVER_STAT_RANGE_MATCH, 1);
+  for (i = 0; i < range->len; i++) {
+    c = &range->intervals[i];
+    res = bound_compare(key, exact, pr, prlen, &c->hi);
+    if (res > 0 || (res == 0 && !c->hi.inclusive)) continue;
+    /* Intervals are sorted and disjoint: no later one can match */
+    res = bound_compare(key, exact, pr, prlen, &c->lo);
+    return res > 0 || (res == 0 && c->lo.inclusive);
+  }
+
+  return 0;
+}
+
+/**
+ * Checks if a version satisfies a compiled range.
+ * Versions with negative components never do.
+ *
+ * Returns:
+ *
+ * `1` - Can be satisfied
+ * `0` - Cannot be satisfied
+ */
+
+SEMVER_API int
+semver_range_match (const semver_range_t *range, const semver_t *ver) {
+  semver_key_t key;
+  int exact;
+  if ((exact = semver_key(ver, &key)) < 0) return 0;
+  return range_match_key(range, &key, exact, ver->prerelease,
+                         ver->prerelease ? strlen(ver->prerelease) : 0);
+}
+
+/**
+ * Same as `semver_range_match` for borrowed version views.
+ */
+
+SEMVER_API int
+semver_range_match_view (const semver_range_t *range, const semver_view_t *ver) {
+  semver_key_t key;
+  int exact;
+  if ((exact = semver_view_key(ver, &key)) < 0) return 0;
+  return range_match_key(range, &key, exact,
+                         ver->prerelease.len ? ver->src + ver->prerelease.offset : NULL,
+                         ver->prerelease.len);
+}
+
+/**
+ * Free memory owned by a compiled range.
+ */
+
+SEMVER_API void
+semver_range_free (semver_range_t *range) {
+  free(range->intervals);
+  free(range->src);
+  range->intervals = NULL;
+  range->src = NULL;
+  range->len = 0;
+}
+
+/**
+ * Range algebra
+ *
+ * Set operations over compiled ranges, as needed by version solvers
+ * to combine the constraints on a package and detect conflicts. They
+ * work on the sorted intervals in linear time, without looking at any
+ * version list. Results own their bounds: prereleases are copied from
+ * the operands into the `src` of the result.
+ */
+
+static int
+range_own (semver_range_t *range, semver_interval_t *intervals, size_t n) {
+  semver_bound_t *b;
+  size_t i, size;
+  char *src, *p;
+
+  for (i = 0, size = 0; i < 2 * n; i++) {
+    b = i & 1 ? &intervals[i / 2].hi : &intervals[i / 2].lo;
+    size += b->prerelease_len;
+  }
+
+  src = (char*)mem_alloc(size + 1);
+  if (src == NULL) {
+    free(intervals);
+    return -1;
+  }
+
+  for (i = 0, p = src; i < 2 * n; i++) {
+    b = i & 1 ? &intervals[i / 2].hi : &intervals[i / 2].lo;
+    if (b->prerelease == NULL) continue;
+    memcpy(p, b->prerelease, b->prerelease_len);
+    b->prerelease = p;
+    p += b->prerelease_len;
+  }
+
+  range->intervals = intervals;
+  range->len = n;
+  range->src = src;
+  return 0;
+}
+
+static semver_interval_t *
+range_alloc (size_t n) {
+  return (semver_interval_t*)mem_alloc((n ? n : 1) * sizeof(semver_interval_t));
+}
+
+/**
+ * Computes the versions satisfying both `a` and `b` into `out`, which
+ * must be released with `semver_range_free`. An empty result has no
+ * intervals. `out` must not be one of the operands.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_range_intersect (const semver_range_t *a, const semver_range_t *b, semver_range_t *out) {
+  semver_interval_t *intervals, c;
+  size_t i, j, n;
+
+  intervals = range_alloc(a->len + b->len);
+  if (intervals == NULL) return -1;
+
+  for (i = 0, j = 0, n = 0; i < a->len && j < b->len; ) {
+    c = a->intervals[i];
+    interval_intersect(&c, &b->intervals[j]);
+    if (!interval_empty(&c)) intervals[n++] = c;
+    /* Drop the interval ending first: it cannot overlap the next ones */
+    if (upper_compare(&a->intervals[i].hi, &b->intervals[j].hi) < 0) i++;
+    else j++;
+  }
+
+  return range_own(out, intervals, n);
+}
+
+/**
+ * Computes the versions satisfying `a` or `b` into `out`, as in
+ * `semver_range_intersect`.
+ */
+
+SEMVER_API int
+semver_range_union (const semver_range_t *a, const semver_range_t *b, semver_range_t *out) {
+  semver_interval_t *intervals;
+  size_t i, j, n;
+
+  intervals = range_alloc(a->len + b->len);
+  if (intervals == NULL) return -1;
+
+  for (i = 0, j = 0, n = 0; i < a->len || j < b->len; n++) {
+    if (j == b->len || (i < a->len && lower_compare(&a->intervals[i].lo, &b->intervals[j].lo) <= 0))
+      intervals[n] = a->intervals[i++];
+    else
+      intervals[n] = b->intervals[j++];
+  }
+
+  return range_own(out, intervals, range_merge(intervals, n));
+}
+
+/**
+ * Computes the versions not satisfying `a` into `out`, as in
+ * `semver_range_intersect`.
+ */
+
+SEMVER_API int
+semver_range_complement (const semver_range_t *a, semver_range_t *out) {
+  semver_interval_t *intervals, all, c;
+  size_t i, n;
+
+  intervals = range_alloc(a->len + 1);
+  if (intervals == NULL) return -1;
+
+  set_unbounded(&all);
+  c.lo = all.lo;
+  for (i = 0, n = 0; i <= a->len; i++) {
+    if (i < a->len) {
+      c.hi = a->intervals[i].lo;
+      c.hi.inclusive = !c.hi.inclusive;
+    } else {
+      c.hi = all.hi;
+    }
+    if (!interval_empty(&c)) intervals[n++] = c;
+    if (i < a->len) {
+      c.lo = a->intervals[i].hi;
+      c.lo.inclusive = !c.lo.inclusive;
+    }
+  }
+
+  return range_own(out, intervals, n);
+}
+
+/**
+ * Checks if some version satisfies both `a` and `b`,
+ * without computing their intersection.
+ *
+ * Returns:
+ *
+ * `1` - The ranges overlap
+ * `0` - The ranges are disjoint
+ */
+
+SEMVER_API int
+semver_range_intersects (const semver_range_t *a, const semver_range_t *b) {
+  semver_interval_t c;
+  size_t i, j;
+
+  for (i = 0, j = 0; i < a->len && j < b->len; ) {
+    c = a->intervals[i];
+    interval_intersect(&c, &b->intervals[j]);
+    if (!interval_empty(&c)) return 1;
+    if (upper_compare(&a->intervals[i].hi, &b->intervals[j].hi) < 0) i++;
+    else j++;
+  }
+
+  return 0;
+}
+
+/**
+ * Checks if every version satisfying `a` also satisfies `b`.
+ * An empty `a` is a subset of any range.
+ *
+ * Returns:
+ *
+ * `1` - `a` is a subset of `b`
+ * `0` - Some version satisfies `a` but not `b`
+ */
+
+SEMVER_API int
+semver_range_subset (const semver_range_t *a, const semver_range_t *b) {
+  size_t i, j;
+
+  for (i = 0, j = 0; i < a->len; i++) {
+    /* Intervals of b are disjoint: only the first one ending after
+       the interval of a can contain it */
+    while (j < b->len && upper_compare(&b->intervals[j].hi, &a->intervals[i].hi) < 0) j++;
+    if (j == b->len || lower_compare(&b->intervals[j].lo, &a->intervals[i].lo) > 0) return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * Version index
+ *
+ * Versions are sorted once and their keys stored in Eytzinger (BFS)
+ * order, where the two children of slot `k` are `2k` and `2k + 1`.
+ * Binary searches then walk the array top down, touching the first
+ * levels from the same few cache lines, and every range interval is
+ * resolved with two searches instead of a scan.
+ */
+
+/*
+ * Stable merge sort of `perm` by `semver_compare` of the versions they point
+ * to, used to order versions sharing an inexact key.
+ */
+static void
+perm_sort (size_t *perm, size_t *tmp, size_t n, const semver_t *arr) {
+  size_t i, j, k, mid, p;
+  if (n < 8) {
+    for (i = 1; i < n; i++) {
+      p = perm[i];
+      for (j = i; j > 0 && semver_compare_ptr(&arr[perm[j - 1]], &arr[p]) > 0; j--)
+        perm[j] = perm[j - 1];
+      perm[j] = p;
+    }
+    return;
+  }
+
+  mid = n / 2;
+  perm_sort(perm, tmp, mid, arr);
+  perm_sort(perm + mid, tmp, n - mid, arr);
+
+  for (i = 0, j = mid, k = 0; i < mid && j < n; )
+    tmp[k++] = semver_compare_ptr(&arr[perm[j]], &arr[perm[i]]) < 0 ? perm[j++] : perm[i++];
+  while (i < mid) tmp[k++] = perm[i++];
+  while (j < n) tmp[k++] = perm[j++];
+  memcpy(perm, tmp, n * sizeof(*perm));
+}
+
+static size_t
+eytzinger (semver_index_t *index, const semver_key_t *sorted, size_t i, size_t k) {
+  if (k <= index->len) {
+    i = eytzinger(index, sorted, i, 2 * k);
+    index->keys[k] = sorted[i];
+    index->ranks[k] = i++;
+    i = eytzinger(index, sorted, i, 2 * k + 1);
+  }
+  return i;
+}
+
+/**
+ * Builds a static index over an array of `n` versions.
+ * The index keeps its own copy of every prerelease, so `arr`
+ * does not need to outlive it.
+ *
+ * Returns:
+ *
+ * `0` - Built successfully
+ * `-1` - Memory allocation error or negative component
+ */
+
+SEMVER_API int
+semver_index_build (semver_index_t *index, const semver_t *arr, size_t n) {
+  semver_key_t *sorted;
+  size_t *tmp, i, j, size;
+  char *next;
+  int res;
+
+  memset(index, 0, sizeof(*index));
+  index->len = n;
+
+  sorted = (semver_key_t*)mem_alloc((n ? n : 1) * sizeof(*sorted));
+  tmp = (size_t*)mem_alloc((n ? n : 1) * sizeof(*tmp));
+  index->keys = (semver_key_t*)mem_alloc((n + 1) * sizeof(*index->keys));
+  index->ranks = (size_t*)mem_alloc((n + 1) * sizeof(*index->ranks));
+  index->positions = (size_t*)mem_alloc((n ? n : 1) * sizeof(*index->positions));
+  index->prerelease = (const char**)mem_alloc((n ? n : 1) * sizeof(*index->prerelease));
+  res = -1;
+
+  if (sorted && tmp && index->keys && index->ranks && index->positions && index->prerelease) {
+    size = 0;
+    for (i = 0; i < n; i++) {
+      if (semver_key(&arr[i], &sorted[i]) < 0) break;
+      index->positions[i] = i;
+      if (arr[i].prerelease) size += strlen(arr[i].prerelease) + 1;
+    }
+    if (i == n) res = radix_sort(sorted, index->positions, n);
+    if (res == 0 && size) {
+      index->strings = (char*)mem_alloc(size);
+      if (index->strings == NULL) res = -1;
+    }
+  }
+
+  if (res == 0) {
+    for (i = 0; i < n; i = j) {
+      for (j = i + 1; j < n && semver_key_compare(&sorted[i], &sorted[j]) == 0; j++);
+      if (j - i > 1 && !key_exact(&sorted[i]))
+        perm_sort(index->positions + i, tmp, j - i, arr);
+    }
+
+    next = index->strings;
+    for (i = 0; i < n; i++) {
+      const char *pr = arr[index->positions[i]].prerelease;
+      index->prerelease[i] = NULL;
+      if (pr) {
+        size = strlen(pr) + 1;
+        memcpy(next, pr, size);
+        index->prerelease[i] = next;
+        next += size;
+      }
+    }
+
+    eytzinger(index, sorted, 0, 1);
+  }
+
+  free(sorted);
+  free(tmp);
+  if (res) semver_index_free(index);
+  return res;
+}
+
+/*
+ * Compares the version at Eytzinger slot `k` with a range bound.
+ */
+static int
+index_compare (const semver_index_t *index, size_t k, const semver_bound_t *b) {
+  const char *pr;
+  int res;
+  if ((res = semver_key_compare(&index->keys[k], &b->key))
+      || (b->exact && key_exact(&index->keys[k]))) return res;
+  pr = index->prerelease[index->ranks[k]];
+  return compare_prerelease_n(pr, pr ? strlen(pr) : 0, b->prerelease, b->prerelease_len);
+}
+
+/*
+ * Returns the number of indexed versions lower than the bound,
+ * or lower or equal to it if `inclusive` is set.
+ */
+static size_t
+index_search (const semver_index_t *index, const semver_bound_t *b, int inclusive) {
+  size_t k;
+  int res;
+
+  k = 1;
+  while (k <= index->len) {
+#ifdef __GNUC__
+    __builtin_prefetch(index->keys + 4 * k);
+#endif
+    res = index_compare(index, k, b);
+    k = 2 * k + (inclusive ? res <= 0 : res < 0);
+  }
+
+  /* Drop the trailing right turns and the last left turn */
+  while (k & 1) k >>= 1;
+  k >>= 1;
+
+  return k ? index->ranks[k] : index->len;
+}
+
+/*
+ * Resolves a range interval to the span [start, end) of sorted ranks.
+ */
+static void
+index_span (const semver_index_t *index, const semver_interval_t *c, size_t *start, size_t *end) {
+  *start = index_search(index, &c->lo, !c->lo.inclusive);
+  *end = index_search(index, &c->hi, c->hi.inclusive);
+}
+
+/**
+ * Finds the highest indexed version satisfying `range`,
+ * storing its position in the source array in `pos`.
+ *
+ * Returns:
+ *
+ * `1` - Found
+ * `0` - No version satisfies the range
+ */
+
+SEMVER_API int
+semver_index_max_satisfying (const semver_index_t *index, const semver_range_t *range, size_t *pos) {
+  size_t i, start, end;
+  for (i = range->len; i > 0; i--) {
+    index_span(index, &range->intervals[i - 1], &start, &end);
+    if (start < end) {
+      *pos = index->positions[end - 1];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Finds the lowest indexed version satisfying `range`,
+ * storing its position in the source array in `pos`.
+ *
+ * Returns:
+ *
+ * `1` - Found
+ * `0` - No version satisfies the range
+ */
+
+SEMVER_API int
+semver_index_min_satisfying (const semver_index_t *index, const semver_range_t *range, size_t *pos) {
+  size_t i, start, end;
+  for (i = 0; i < range->len; i++) {
+    index_span(index, &range->intervals[i], &start, &end);
+    if (start < end) {
+      *pos = index->positions[start];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Counts the indexed versions satisfying `range`.
+ */
+
+SEMVER_API size_t
+semver_index_count_satisfying (const semver_index_t *index, const semver_range_t *range) {
+  size_t i, start, end, count;
+  for (i = 0, count = 0; i < range->len; i++) {
+    index_span(index, &range->intervals[i], &start, &end);
+    if (start < end) count += end - start;
+  }
+  return count;
+}
+
+/**
+ * Free memory owned by an index.
+ */
+
+SEMVER_API void
+semver_index_free (semver_index_t *index) {
+  free(index->keys);
+  free(index->ranks);
+  free(index->positions);
+  free((void *) index->prerelease);
+  free(index->strings);
+  memset(index, 0, sizeof(*index));
+}
+
+/**
+ * Bitmaps
+ *
+ * Roaring style compressed bitmaps: values are split by their high 16
+ * bits into containers sorted by key. A container holds its low 16 bits
+ * as a sorted array while it has at most BITMAP_ARRAY_MAX values, where
+ * the array is smaller than a 65536 bit set, and as a bit set above.
+ * Operations work container by container and normalize every result.
+ */
+
+#define BITMAP_ARRAY_MAX 4096
+#define BITMAP_WORD_BITS (CHAR_BIT * sizeof(unsigned long))
+#define BITMAP_WORDS (65536 / BITMAP_WORD_BITS)
+
+struct semver_bitmap_container_s {
+  size_t key;
+  size_t card;
+  unsigned short *array;
+  unsigned long *words;
+};
+
+enum bitmap_op {
+  BITMAP_AND,
+  BITMAP_OR,
+  BITMAP_ANDNOT
+};
+
+static size_t
+popcount (unsigned long w) {
+#ifdef __GNUC__
+  return (size_t) __builtin_popcountl(w);
+#else
+  size_t n;
+  for (n = 0; w; n++) w &= w - 1;
+  return n;
+#endif
+}
+
+static unsigned int
+lowest_bit (unsigned long w) {
+#ifdef __GNUC__
+  return (unsigned int) __builtin_ctzl(w);
+#else
+  unsigned int n;
+  for (n = 0; !(w & 1); n++) w >>= 1;
+  return n;
+#endif
+}
+
+static void
+container_free (struct semver_bitmap_container_s *c) {
+  free(c->array);
+  free(c->words);
+}
+
+/*
+ * Stores the `card` bits set in `words` (taking ownership of them) in
+ * `c`, converted to an array if small enough.
+ */
+static int
+container_from_words (struct semver_bitmap_container_s *c, size_t key,
+                      unsigned long *words, size_t card) {
+  unsigned long w;
+  size_t i, n;
+
+  c->key = key;
+  c->card = card;
+  c->array = NULL;
+  c->words = words;
+  if (card > BITMAP_ARRAY_MAX) return 0;
+
+  c->array = (unsigned short*)mem_alloc(card * sizeof(*c->array) + 1);
+  if (c->array == NULL) {
+    free(words);
+    c->words = NULL;
+    return -1;
+  }
+  for (i = 0, n = 0; i < BITMAP_WORDS; i++) {
+    for (w = words[i]; w; w &= w - 1)
+      c->array[n++] = (unsigned short) (i * BITMAP_WORD_BITS + lowest_bit(w));
+  }
+  free(words);
+  c->words = NULL;
+  return 0;
+}
+
+/* Expands a container into a caller provided bit set */
+static void
+container_words (const struct semver_bitmap_container_s *c, unsigned long *words) {
+  size_t i;
+  if (c->words) {
+    memcpy(words, c->words, BITMAP_WORDS * sizeof(*words));
+    return;
+  }
+  memset(words, 0, BITMAP_WORDS * sizeof(*words));
+  for (i = 0; i < c->card; i++)
+    words[c->array[i] / BITMAP_WORD_BITS] |= 1UL << (c->array[i] % BITMAP_WORD_BITS);
+}
+
+static int
+container_has (const struct semver_bitmap_container_s *c, unsigned int v) {
+  size_t lo, hi, mid;
+  if (c->words) return (c->words[v / BITMAP_WORD_BITS] >> (v % BITMAP_WORD_BITS)) & 1;
+  for (lo = 0, hi = c->card; lo < hi; ) {
+    mid = lo + (hi - lo) / 2;
+    if (c->array[mid] < v) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < c->card && c->array[lo] == v;
+}
+
+/*
+ * Combines two containers with the same key into `out`, which is left
+ * with a zero cardinality if the result is empty.
+ */
+static int
+container_op (enum bitmap_op op, const struct semver_bitmap_container_s *a,
+              const struct semver_bitmap_container_s *b, struct semver_bitmap_container_s *out) {
+  unsigned long *words, *other;
+  size_t i, j, n, card;
+
+  out->key = a->key;
+  out->card = 0;
+  out->array = NULL;
+  out->words = NULL;
+
+  /* Array results: merge two arrays, or filter an array by the other */
+  if (a->array && (op != BITMAP_OR || (b->array && a->card + b->card <= BITMAP_ARRAY_MAX))) {
+    out->array = (unsigned short*)mem_alloc((a->card + (op == BITMAP_OR ? b->card : 0))
+                                         * sizeof(*out->array) + 1);
+    if (out->array == NULL) return -1;
+    n = 0;
+    if (b->words) {
+      for (i = 0; i < a->card; i++)
+        if (container_has(b, a->array[i]) == (op == BITMAP_AND)) out->array[n++] = a->array[i];
+    } else {
+      for (i = 0, j = 0; i < a->card || j < b->card; ) {
+        if (j == b->card || (i < a->card && a->array[i] < b->array[j])) {
+          if (op != BITMAP_AND) out->array[n++] = a->array[i];
+          i++;
+        } else if (i == a->card || b->array[j] < a->array[i]) {
+          if (op == BITMAP_OR) out->array[n++] = b->array[j];
+          j++;
+        } else {
+          if (op != BITMAP_ANDNOT) out->array[n++] = a->array[i];
+          i++;
+          j++;
+        }
+      }
+    }
+    out->card = n;
+    return 0;
+  }
+
+  if (op == BITMAP_AND && b->array) return container_op(op, b, a, out);
+
+  /* Bit set results */
+  words = (unsigned long*)mem_alloc(BITMAP_WORDS * sizeof(*words));
+  other = (unsigned long*)mem_alloc(BITMAP_WORDS * sizeof(*other));
+  if (words == NULL || other == NULL) {
+    free(words);
+    free(other);
+    return -1;
+  }
+  container_words(a, words);
+  container_words(b, other);
+  for (i = 0, card = 0; i < BITMAP_WORDS; i++) {
+    if (op == BITMAP_AND) words[i] &= other[i];
+    else if (op == BITMAP_OR) words[i] |= other[i];
+    else words[i] &= ~other[i];
+    card += popcount(words[i]);
+  }
+  free(other);
+  return container_from_words(out, a->key, words, card);
+}
+
+static int
+container_copy (const struct semver_bitmap_container_s *c, struct semver_bitmap_container_s *out) {
+  *out = *c;
+  if (c->array) {
+    out->array = (unsigned short*)mem_alloc(c->card * sizeof(*out->array));
+    if (out->array == NULL) return -1;
+    memcpy(out->array, c->array, c->card * sizeof(*out->array));
+  } else {
+    out->words = (unsigned long*)mem_alloc(BITMAP_WORDS * sizeof(*out->words));
+    if (out->words == NULL) return -1;
+    memcpy(out->words, c->words, BITMAP_WORDS * sizeof(*out->words));
+  }
+  return 0;
+}
+
+static int
+bitmap_push (semver_bitmap_t *bitmap, struct semver_bitmap_container_s *c) {
+  struct semver_bitmap_container_s *containers;
+  size_t cap;
+
+  if (c->card == 0) {
+    container_free(c);
+    return 0;
+  }
+
+  if (bitmap->len == bitmap->cap) {
+    cap = bitmap->cap ? bitmap->cap * 2 : 4;
+    containers = (struct semver_bitmap_container_s*)mem_alloc(cap * sizeof(*containers));
+    if (containers == NULL) {
+      container_free(c);
+      return -1;
+    }
+    if (bitmap->len) memcpy(containers, bitmap->containers, bitmap->len * sizeof(*containers));
+    free(bitmap->containers);
+    bitmap->containers = containers;
+    bitmap->cap = cap;
+  }
+
+  bitmap->containers[bitmap->len++] = *c;
+  return 0;
+}
+
+static int
+bitmap_op (enum bitmap_op op, const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out) {
+  struct semver_bitmap_container_s c;
+  const struct semver_bitmap_container_s *x, *y;
+  size_t i, j;
+  int res;
+
+  semver_bitmap_init(out);
+  for (i = 0, j = 0; i < a->len || j < b->len; ) {
+    x = i < a->len ? &a->containers[i] : NULL;
+    y = j < b->len ? &b->containers[j] : NULL;
+
+    if (x && y && x->key == y->key) {
+      res = container_op(op, x, y, &c);
+      i++;
+      j++;
+    } else if (x && (y == NULL || x->key < y->key)) {
+      /* Only in a */
+      i++;
+      if (op == BITMAP_AND) continue;
+      res = container_copy(x, &c);
+    } else {
+      /* Only in b */
+      j++;
+      if (op != BITMAP_OR) continue;
+      res = container_copy(y, &c);
+    }
+
+    if (res || bitmap_push(out, &c)) {
+      semver_bitmap_free(out);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Initializes an empty bitmap.
+ */
+
+SEMVER_API void
+semver_bitmap_init (semver_bitmap_t *bitmap) {
+  memset(bitmap, 0, sizeof(*bitmap));
+}
+
+/**
+ * Builds the bitmap of the positions, in the array the index was built
+ * from, of the versions satisfying `range`. `out` must be released with
+ * `semver_bitmap_free`.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_index_bitmap (const semver_index_t *index, const semver_range_t *range, semver_bitmap_t *out) {
+  struct semver_bitmap_container_s c;
+  unsigned long *flat, *words;
+  size_t i, k, r, start, end, size, card;
+
+  semver_bitmap_init(out);
+  if (index->len == 0) return 0;
+
+  /* Set the bits in a flat bit set, then compress it container by container */
+  size = (index->len + 65535) / 65536 * BITMAP_WORDS;
+  flat = (unsigned long*)mem_calloc(size, sizeof(*flat));
+  if (flat == NULL) return -1;
+
+  for (i = 0; i < range->len; i++) {
+    index_span(index, &range->intervals[i], &start, &end);
+    for (r = start; r < end; r++)
+      flat[index->positions[r] / BITMAP_WORD_BITS] |= 1UL << (index->positions[r] % BITMAP_WORD_BITS);
+  }
+
+  for (k = 0; k < size; k += BITMAP_WORDS) {
+    for (i = 0, card = 0; i < BITMAP_WORDS; i++) card += popcount(flat[k + i]);
+    if (card == 0) continue;
+    words = (unsigned long*)mem_alloc(BITMAP_WORDS * sizeof(*words));
+    if (words) memcpy(words, flat + k, BITMAP_WORDS * sizeof(*words));
+    if (words == NULL || container_from_words(&c, k / BITMAP_WORDS, words, card)
+        || bitmap_push(out, &c)) {
+      free(flat);
+      semver_bitmap_free(out);
+      return -1;
+    }
+  }
+
+  free(flat);
+  return 0;
+}
+
+/**
+ * Computes the values in both `a` and `b` into `out`, which must not
+ * be one of the operands and must be released with `semver_bitmap_free`.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_bitmap_and (const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out) {
+  return bitmap_op(BITMAP_AND, a, b, out);
+}
+
+/**
+ * Computes the values in `a` or `b`, as in `semver_bitmap_and`.
+ */
+
+SEMVER_API int
+semver_bitmap_or (const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out) {
+  return bitmap_op(BITMAP_OR, a, b, out);
+}
+
+/**
+ * Computes the values in `a` but not in `b`, as in `semver_bitmap_and`.
+ */
+
+SEMVER_API int
+semver_bitmap_andnot (const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out) {
+  return bitmap_op(BITMAP_ANDNOT, a, b, out);
+}
+
+/**
+ * Returns the number of values in a bitmap.
+ */
+
+SEMVER_API size_t
+semver_bitmap_cardinality (const semver_bitmap_t *bitmap) {
+  size_t i, card;
+  for (i = 0, card = 0; i < bitmap->len; i++) card += bitmap->containers[i].card;
+  return card;
+}
+
+/**
+ * Returns 1 if `x` is in the bitmap, 0 otherwise.
+ */
+
+SEMVER_API int
+semver_bitmap_contains (const semver_bitmap_t *bitmap, size_t x) {
+  size_t lo, hi, mid;
+  for (lo = 0, hi = bitmap->len; lo < hi; ) {
+    mid = lo + (hi - lo) / 2;
+    if (bitmap->containers[mid].key < x >> 16) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < bitmap->len && bitmap->containers[lo].key == x >> 16
+    && container_has(&bitmap->containers[lo], (unsigned int) (x & 0xffff));
+}
+
+/**
+ * Writes the values of a bitmap in ascending order to `out`, which
+ * must hold `semver_bitmap_cardinality` values. Returns their number.
+ */
+
+SEMVER_API size_t
+semver_bitmap_values (const semver_bitmap_t *bitmap, size_t *out) {
+  const struct semver_bitmap_container_s *c;
+  unsigned long w;
+  size_t i, j, n, base;
+
+  for (i = 0, n = 0; i < bitmap->len; i++) {
+    c = &bitmap->containers[i];
+    base = c->key << 16;
+    if (c->array) {
+      for (j = 0; j < c->card; j++) out[n++] = base + c->array[j];
+    } else {
+      for (j = 0; j < BITMAP_WORDS; j++)
+        for (w = c->words[j]; w; w &= w - 1)
+          out[n++] = base + j * BITMAP_WORD_BITS + lowest_bit(w);
+    }
+  }
+
+  return n;
+}
+
+/**
+ * Free memory owned by a bitmap.
+ */
+
+SEMVER_API void
+semver_bitmap_free (semver_bitmap_t *bitmap) {
+  size_t i;
+  for (i = 0; i < bitmap->len; i++) container_free(&bitmap->containers[i]);
+  free(bitmap->containers);
+  semver_bitmap_init(bitmap);
+}
+
+/**
+ * Columns
+ *
+ * Versions stored as a structure of arrays: one column per key word,
+ * so a bound is compared against 8 (AVX2) or 4 (SSE2) versions at once.
+ * Words are unsigned while SIMD compares are signed, so both sides are
+ * biased by flipping the top bit. Only versions equal to an inexact
+ * bound, whose prerelease must be compared, are resolved one by one;
+ * equal ranks always have the same exactness.
+ */
+
+#if defined(SEMVER_SSE2) && UINT_MAX == 0xffffffffUL
+#define COLUMN_SIMD 1
+#endif
+
+#define COLUMN_BIAS 0x80000000UL
+
+static int
+column_has (const semver_column_t *col, size_t i, const semver_interval_t *c) {
+  semver_key_t key;
+  const char *pr;
+  int exact, res;
+
+  key.w[0] = col->major[i];
+  key.w[1] = col->minor[i];
+  key.w[2] = col->patch[i];
+  key.w[3] = col->rank[i];
+  exact = key_exact(&key);
+  pr = col->prerelease[i];
+
+  res = bound_compare(&key, exact, pr, pr ? strlen(pr) : 0, &c->lo);
+  if (res < 0 || (res == 0 && !c->lo.inclusive)) return 0;
+  res = bound_compare(&key, exact, pr, pr ? strlen(pr) : 0, &c->hi);
+  return res < 0 || (res == 0 && c->hi.inclusive);
+}
+
+/*
+ * Kernels set, or add if `merge` is set, the bit of every version
+ * of the column inside the interval.
+ */
+
+typedef void (*column_fn)(const semver_column_t *, const semver_interval_t *,
+                          unsigned char *, int);
+
+#ifndef COLUMN_SIMD
+
+static void
+column_scalar (const semver_column_t *col, const semver_interval_t *c,
+               unsigned char *bitmap, int merge) {
+  unsigned char bits;
+  size_t i;
+
+  for (i = 0, bits = 0; i < col->len; i++) {
+    if (column_has(col, i, c)) bits |= (unsigned char) (1 << (i & 7));
+    if ((i & 7) == 7 || i + 1 == col->len) {
+      bitmap[i >> 3] = merge ? bitmap[i >> 3] | bits : bits;
+      bits = 0;
+    }
+  }
+}
+
+#else
+
+/* Resolves the lanes of a block equal to an inexact bound */
+static unsigned int
+column_ties (const semver_column_t *col, size_t i, const semver_interval_t *c,
+             unsigned int mask, unsigned int ties) {
+  unsigned int j;
+  for (j = 0; j < 8; j++) {
+    if (!(ties & (1u << j))) continue;
+    if (column_has(col, i + j, c)) mask |= 1u << j;
+    else mask &= ~(1u << j);
+  }
+  return mask;
+}
+
+/*
+ * Lexicographic compare of the 4 words of x against b:
+ * sets `gt` and `eq` lanes, from the least significant word up.
+ */
+#define SSE2_WORD_COMPARE(x, b, k, gt, eq) do { \
+    __m128i e_ = _mm_cmpeq_epi32(x[k], b[k]); \
+    gt = _mm_or_si128(_mm_cmpgt_epi32(x[k], b[k]), _mm_and_si128(e_, gt)); \
+    eq = _mm_and_si128(e_, eq); \
+  } while (0)
+
+#define SSE2_KEY_COMPARE(x, b, gt, eq) do { \
+    gt = _mm_cmpgt_epi32(x[3], b[3]); \
+    eq = _mm_cmpeq_epi32(x[3], b[3]); \
+    SSE2_WORD_COMPARE(x, b, 2, gt, eq); \
+    SSE2_WORD_COMPARE(x, b, 1, gt, eq); \
+    SSE2_WORD_COMPARE(x, b, 0, gt, eq); \
+  } while (0)
+
+static unsigned int
+column_sse2_lanes (const semver_column_t *col, size_t i, const __m128i *lo, const __m128i *hi,
+                   __m128i lo_inc, __m128i hi_inc, unsigned int *eq_lo, unsigned int *eq_hi) {
+  const __m128i bias = _mm_set1_epi32((int) COLUMN_BIAS);
+  __m128i x[4], gt, eq, lt, eq2, in;
+
+  x[0] = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (col->major + i)), bias);
+  x[1] = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (col->minor + i)), bias);
+  x[2] = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (col->patch + i)), bias);
+  x[3] = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (col->rank + i)), bias);
+
+  SSE2_KEY_COMPARE(x, lo, gt, eq);
+  SSE2_KEY_COMPARE(hi, x, lt, eq2);
+  in = _mm_and_si128(_mm_or_si128(gt, _mm_and_si128(eq, lo_inc)),
+                     _mm_or_si128(lt, _mm_and_si128(eq2, hi_inc)));
+
+  *eq_lo = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(eq));
+  *eq_hi = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(eq2));
+  return (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(in));
+}
+
+static void
+column_sse2 (const semver_column_t *col, const semver_interval_t *c,
+             unsigned char *bitmap, int merge) {
+  __m128i lo[4], hi[4], lo_inc, hi_inc;
+  unsigned int mask, ties, eq_lo, eq_hi, eq_lo2, eq_hi2;
+  size_t i;
+  int k;
+
+  for (k = 0; k < 4; k++) {
+    lo[k] = _mm_set1_epi32((int) (c->lo.key.w[k] ^ COLUMN_BIAS));
+    hi[k] = _mm_set1_epi32((int) (c->hi.key.w[k] ^ COLUMN_BIAS));
+  }
+  lo_inc = _mm_set1_epi32(c->lo.inclusive ? -1 : 0);
+  hi_inc = _mm_set1_epi32(c->hi.inclusive ? -1 : 0);
+
+  for (i = 0; i + 8 <= col->len; i += 8) {
+    mask = column_sse2_lanes(col, i, lo, hi, lo_inc, hi_inc, &eq_lo, &eq_hi)
+      | column_sse2_lanes(col, i + 4, lo, hi, lo_inc, hi_inc, &eq_lo2, &eq_hi2) << 4;
+    ties = (c->lo.exact ? 0 : eq_lo | eq_lo2 << 4) | (c->hi.exact ? 0 : eq_hi | eq_hi2 << 4);
+    if (ties) mask = column_ties(col, i, c, mask, ties);
+    bitmap[i >> 3] = (unsigned char) (merge ? bitmap[i >> 3] | mask : mask);
+  }
+
+  for (; i < col->len; i++) {
+    if (merge == 0 && (i & 7) == 0) bitmap[i >> 3] = 0;
+    if (column_has(col, i, c)) bitmap[i >> 3] |= (unsigned char) (1 << (i & 7));
+  }
+}
+
+#ifdef SEMVER_AVX2
+
+#define AVX2_WORD_COMPARE(x, b, k, gt, eq) do { \
+    __m256i e_ = _mm256_cmpeq_epi32(x[k], b[k]); \
+    gt = _mm256_or_si256(_mm256_cmpgt_epi32(x[k], b[k]), _mm256_and_si256(e_, gt)); \
+    eq = _mm256_and_si256(e_, eq); \
+  } while (0)
+
+#define AVX2_KEY_COMPARE(x, b, gt, eq) do { \
+    gt = _mm256_cmpgt_epi32(x[3], b[3]); \
+    eq = _mm256_cmpeq_epi32(x[3], b[3]); \
+    AVX2_WORD_COMPARE(x, b, 2, gt, eq); \
+    AVX2_WORD_COMPARE(x, b, 1, gt, eq); \
+    AVX2_WORD_COMPARE(x, b, 0, gt, eq); \
+  } while (0)
+
+__attribute__((target("avx2")))
+static void
+column_avx2 (const semver_column_t *col, const semver_interval_t *c,
+             unsigned char *bitmap, int merge) {
+  __m256i lo[4], hi[4], x[4], lo_inc, hi_inc, bias, gt, eq, lt, eq2, in;
+  unsigned int mask, ties;
+  size_t i;
+  int k;
+
+  bias = _mm256_set1_epi32((int) COLUMN_BIAS);
+  for (k = 0; k < 4; k++) {
+    lo[k] = _mm256_set1_epi32((int) (c->lo.key.w[k] ^ COLUMN_BIAS));
+    hi[k] = _mm256_set1_epi32((int) (c->hi.key.w[k] ^ COLUMN_BIAS));
+  }
+  lo_inc = _mm256_set1_epi32(c->lo.inclusive ? -1 : 0);
+  hi_inc = _mm256_set1_epi32(c->hi.inclusive ? -1 : 0);
+
+  for (i = 0; i + 8 <= col->len; i += 8) {
+    x[0] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (col->major + i)), bias);
+    x[1] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (col->minor + i)), bias);
+    x[2] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (col->patch + i)), bias);
+    x[3] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (col->rank + i)), bias);
+
+    AVX2_KEY_COMPARE(x, lo, gt, eq);
+    AVX2_KEY_COMPARE(hi, x, lt, eq2);
+    in = _mm256_and_si256(_mm256_or_si256(gt, _mm256_and_si256(eq, lo_inc)),
+                          _mm256_or_si256(lt, _mm256_and_si256(eq2, hi_inc)));
+    mask = (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(in));
+
+    ties = (c->lo.exact ? 0 : (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(eq)))
+         | (c->hi.exact ? 0 : (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(eq2)));
+    if (ties) mask = column_ties(col, i, c, mask, ties);
+    bitmap[i >> 3] = (unsigned char) (merge ? bitmap[i >> 3] | mask : mask);
+  }
+
+  /* Clear the upper halves before running legacy SSE code on the tail */
+  _mm256_zeroupper();
+  for (; i < col->len; i++) {
+    if (merge == 0 && (i & 7) == 0) bitmap[i >> 3] = 0;
+    if (column_has(col, i, c)) bitmap[i >> 3] |= (unsigned char) (1 << (i & 7));
+  }
+}
+
+#endif
+#endif
+
+static kernel_fn
+select_column_kernel (void) {
+#if defined(COLUMN_SIMD) && defined(SEMVER_AVX2)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return (kernel_fn) column_avx2;
+#endif
+#ifdef COLUMN_SIMD
+  return (kernel_fn) column_sse2;
+#else
+  return (kernel_fn) column_scalar;
+#endif
+}
+
+static kernel_fn column_kernel = NULL;
+
+static size_t
+column_match (const semver_column_t *col, const semver_interval_t *c, size_t count,
+              unsigned char *bitmap) {
+  column_fn kernel = (column_fn) kernel_get(&column_kernel, select_column_kernel);
+  unsigned long word;
+  size_t i, matches;
+
+  if (count == 0) memset(bitmap, 0, (col->len + 7) / 8);
+  for (i = 0; i < count; i++) kernel(col, &c[i], bitmap, i > 0);
+
+  /* Counted a word at a time: without a popcount instruction each call is costly */
+  for (i = 0, matches = 0; i + sizeof(word) <= col->len / 8; i += sizeof(word)) {
+    memcpy(&word, bitmap + i, sizeof(word));
+    matches += popcount(word);
+  }
+  for (; i < col->len / 8; i++) matches += popcount(bitmap[i]);
+  if (col->len & 7) matches += popcount(bitmap[i] & ((1u << (col->len & 7)) - 1));
+  return matches;
+}
+
+/*
+ * Interval of the versions satisfying `op` against `y`, as decided by
+ * `semver_satisfies_op`. Tilde and caret ignore prereleases, so their
+ * bounds span every rank.
+ */
+static void
+op_interval (const semver_t *y, semver_op_t op, semver_interval_t *c) {
+  size_t len = y->prerelease ? strlen(y->prerelease) : 0;
+
+  set_unbounded(c);
+  switch (op) {
+    case SEMVER_OP_EQ:
+    case SEMVER_OP_GT:
+    case SEMVER_OP_GTE:
+      set_bound(&c->lo, y->major, y->minor, y->patch, y->prerelease, len, op != SEMVER_OP_GT);
+      if (op == SEMVER_OP_EQ) c->hi = c->lo;
+      break;
+    case SEMVER_OP_LT:
+    case SEMVER_OP_LTE:
+      set_bound(&c->hi, y->major, y->minor, y->patch, y->prerelease, len, op == SEMVER_OP_LTE);
+      break;
+    case SEMVER_OP_TILDE:
+      set_bound(&c->lo, y->major, y->minor, 0, LOWEST_PRERELEASE, 1, 1);
+      set_bound(&c->hi, y->major, y->minor, KEY_MASK, NULL, 0, 1);
+      break;
+    case SEMVER_OP_CARET:
+      if (y->major) {
+        set_bound(&c->lo, y->major, y->minor, y->patch, LOWEST_PRERELEASE, 1, 1);
+        set_bound(&c->hi, y->major, KEY_MASK, KEY_MASK, NULL, 0, 1);
+      } else {
+        set_bound(&c->lo, 0, y->minor, y->patch, LOWEST_PRERELEASE, 1, 1);
+        set_bound(&c->hi, 0, y->minor, y->minor ? KEY_MASK : (unsigned long) y->patch, NULL, 0, 1);
+      }
+      break;
+  }
+}
+
+/**
+ * Builds a column store of `n` versions: separate arrays of majors,
+ * minors, patches and prerelease ranks. Prereleases are copied only
+ * when their rank is not enough to compare them.
+ * Release it with `semver_column_free`.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Memory allocation error or negative component
+ */
+
+SEMVER_API int
+semver_column_build (semver_column_t *col, const semver_t *arr, size_t n) {
+  semver_key_t key;
+  size_t i, size, len;
+  char *next;
+  int exact;
+
+  memset(col, 0, sizeof(*col));
+  col->major = (semver_word_t*)mem_alloc((n ? n : 1) * sizeof(*col->major));
+  col->minor = (semver_word_t*)mem_alloc((n ? n : 1) * sizeof(*col->minor));
+  col->patch = (semver_word_t*)mem_alloc((n ? n : 1) * sizeof(*col->patch));
+  col->rank = (semver_word_t*)mem_alloc((n ? n : 1) * sizeof(*col->rank));
+  col->prerelease = (const char**)mem_alloc((n ? n : 1) * sizeof(*col->prerelease));
+  if (!col->major || !col->minor || !col->patch || !col->rank || !col->prerelease) {
+    semver_column_free(col);
+    return -1;
+  }
+
+  for (i = 0, size = 0; i < n; i++) {
+    col->prerelease[i] = NULL;
+    if ((exact = semver_key(&arr[i], &key)) < 0) {
+      semver_column_free(col);
+      return -1;
+    }
+    if (exact == 0) {
+      /* Points to the source until the strings are copied below */
+      col->prerelease[i] = arr[i].prerelease;
+      size += strlen(arr[i].prerelease) + 1;
+    }
+    col->major[i] = key.w[0];
+    col->minor[i] = key.w[1];
+    col->patch[i] = key.w[2];
+    col->rank[i] = key.w[3];
+  }
+
+  if (size && (col->strings = (char*)mem_alloc(size)) == NULL) {
+    semver_column_free(col);
+    return -1;
+  }
+
+  for (i = 0, next = col->strings; i < n; i++) {
+    if (col->prerelease[i] == NULL) continue;
+    len = strlen(col->prerelease[i]) + 1;
+    memcpy(next, col->prerelease[i], len);
+    col->prerelease[i] = next;
+    next += len;
+  }
+
+  col->len = n;
+  return 0;
+}
+
+/**
+ * Checks every version of a column against `y` with `semver_satisfies_op`,
+ * with the same bitmap layout as `semver_satisfies_op_many`: bit `i % 8`
+ * of `bitmap[i / 8]` is set when version `i` satisfies it. Whole blocks
+ * of versions are compared at once with SSE2 or AVX2, selected at runtime.
+ *
+ * Returns the number of satisfying versions.
+ */
+
+SEMVER_API size_t
+semver_satisfies_many (const semver_column_t *col, const semver_t *y, semver_op_t op,
+                       unsigned char *bitmap) {
+  semver_interval_t c;
+  STATS_ADD(SEMVER_STAT_SATISFIES, col->len);
+  op_interval(y, op, &c);
+  return column_match(col, &c, 1, bitmap);
+}
+
+/**
+ * Same as `semver_satisfies_many` for a compiled range,
+ * as decided by `semver_range_match`.
+ */
+
+SEMVER_API size_t
+semver_range_match_many (const semver_column_t *col, const semver_range_t *range,
+                         unsigned char *bitmap) {
+  STATS_ADD(SEMVER_STAT_RANGE_MATCH, col->len);
+  return column_match(col, range->intervals, range->len, bitmap);
+}
+
+/**
+ * Free memory owned by a column.
+ */
+
+SEMVER_API void
+semver_column_free (semver_column_t *col) {
+  free(col->major);
+  free(col->minor);
+  free(col->patch);
+  free(col->rank);
+  free((void *) col->prerelease);
+  free(col->strings);
+  memset(col, 0, sizeof(*col));
+}
+
+/**
+ * Packed lists
+ *
+ * Binary format for version lists, in little endian:
+ *
+ *   "SVP1" | count (u32) | block size (u32) | block offsets (u32 each) | blocks
+ *
+ * Entries are split into blocks of SEMVER_PACK_BLOCK versions. Each
+ * block is decoded on its own, so one entry is reached by decoding at
+ * most a block. Offsets are relative to the first block. An entry is:
+ *
+ * - A tag: 2 flag bits (has prerelease, has metadata) and the zigzag
+ *   encoded major delta, in a varint whose first byte keeps 5 bits.
+ * - Minor and patch varints. They are zigzag deltas while the higher
+ *   components repeat, and absolute values after a change.
+ * - Prerelease, then metadata if present, front coded against the
+ *   last one in the block: varint shared prefix, varint suffix length,
+ *   suffix bytes.
+ *
+ * Releases in a sorted list mostly take 3 bytes.
+ */
+
+#ifndef SEMVER_PACK_BLOCK
+#define SEMVER_PACK_BLOCK 16
+#endif
+
+#define PACK_HEADER 12
+#define PACK_MAX 0xffffffffUL
+
+static const char PACK_MAGIC[] = "SVP1";
+
+struct pack_cursor {
+  const unsigned char *pos;
+  const unsigned char *end;
+  unsigned long v[3];
+  int present[2];
+  size_t len[2];
+  size_t prefix[2];
+  const unsigned char *suffix[2];
+};
+
+static unsigned long
+zigzag (long d) {
+  return d < 0 ? ((unsigned long) -(d + 1)) * 2 + 1 : (unsigned long) d * 2;
+}
+
+static size_t
+pack_put (unsigned char *dest, size_t cap, size_t pos, unsigned char c) {
+  if (pos < cap) dest[pos] = c;
+  return pos + 1;
+}
+
+static size_t
+pack_varint (unsigned char *dest, size_t cap, size_t pos, unsigned long v) {
+  for (; v > 0x7f; v >>= 7) pos = pack_put(dest, cap, pos, (unsigned char) (v & 0x7f) | 0x80);
+  return pack_put(dest, cap, pos, (unsigned char) v);
+}
+
+static void
+pack_u32 (unsigned char *dest, size_t cap, size_t pos, unsigned long v) {
+  int i;
+  for (i = 0; i < 4; i++, v >>= 8) pack_put(dest, cap, pos + i, (unsigned char) (v & 0xff));
+}
+
+static unsigned long
+pack_u32_get (const unsigned char *p) {
+  return (unsigned long) p[0] | (unsigned long) p[1] << 8
+    | (unsigned long) p[2] << 16 | (unsigned long) p[3] << 24;
+}
+
+/* Reads a varint of at most 5 bytes, enough for any value written */
+static ALWAYS_INLINE int
+pack_read (struct pack_cursor *c, unsigned long *v) {
+  unsigned int shift;
+  unsigned char b;
+
+  /* Single byte values are by far the most common */
+  if (c->pos < c->end && *c->pos < 0x80) {
+    *v = *c->pos++;
+    return 0;
+  }
+
+  *v = 0;
+  for (shift = 0; ; shift += 7) {
+    if (c->pos == c->end || shift > 28) return -1;
+    b = *c->pos++;
+    *v |= (unsigned long) (b & 0x7f) << shift;
+    if (!(b & 0x80)) return 0;
+  }
+}
+
+/*
+ * Applies a zigzag delta, or an absolute value if `absolute`,
+ * to component `i`.
+ */
+static int
+pack_component (struct pack_cursor *c, int i, unsigned long v, int absolute) {
+  unsigned long d = v >> 1;
+  if (absolute) {
+    if (v > (unsigned long) MAX_SAFE_INT) return -1;
+    c->v[i] = v;
+  } else if (v & 1) {
+    if (d + 1 > c->v[i]) return -1;
+    c->v[i] -= d + 1;
+  } else {
+    if (d > (unsigned long) MAX_SAFE_INT - c->v[i]) return -1;
+    c->v[i] += d;
+  }
+  return 0;
+}
+
+/* Number of blocks, computed without overflowing `count + block - 1` */
+static size_t
+pack_blocks (const semver_pack_t *pack) {
+  return pack->count / pack->block + (pack->count % pack->block != 0);
+}
+
+static void
+pack_cursor_init (struct pack_cursor *c, const semver_pack_t *pack, size_t block) {
+  const unsigned char *base;
+  size_t blocks;
+
+  blocks = pack_blocks(pack);
+  base = pack->data + PACK_HEADER + 4 * blocks;
+  c->pos = base + pack_u32_get(pack->data + PACK_HEADER + 4 * block);
+  c->end = block + 1 < blocks
+    ? base + pack_u32_get(pack->data + PACK_HEADER + 4 * (block + 1))
+    : pack->data + pack->len;
+  c->v[0] = c->v[1] = c->v[2] = 0;
+  c->present[0] = c->present[1] = 0;
+  c->len[0] = c->len[1] = 0;
+}
+
+/*
+ * Decodes the next entry of a block. Strings are not copied: `suffix`
+ * points to the bytes following the `prefix` shared with the last
+ * string of the same kind, `len` being the total length.
+ */
+static int
+pack_next (struct pack_cursor *c) {
+  unsigned long v, rest;
+  int f, changed;
+
+  if (c->pos == c->end) return -1;
+  v = *c->pos++;
+  c->present[0] = v & 1;
+  c->present[1] = (v >> 1) & 1;
+  if (v & 0x80) {
+    if (pack_read(c, &rest)) return -1;
+    v = ((v >> 2) & 0x1f) | rest << 5;
+  } else {
+    v >>= 2;
+  }
+
+  changed = v != 0;
+  if (pack_component(c, 0, v, 0)) return -1;
+  if (pack_read(c, &v) || pack_component(c, 1, v, changed)) return -1;
+  changed = changed || v != 0;
+  if (pack_read(c, &v) || pack_component(c, 2, v, changed)) return -1;
+
+  for (f = 0; f < 2; f++) {
+    if (!c->present[f]) continue;
+    if (pack_read(c, &v) || v > c->len[f]) return -1;
+    c->prefix[f] = v;
+    if (pack_read(c, &v) || v > (unsigned long) (c->end - c->pos)) return -1;
+    c->suffix[f] = c->pos;
+    c->pos += v;
+    c->len[f] = c->prefix[f] + v;
+    if (c->len[f] == 0) return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * Packs `n` versions, preferably sorted, into at most `cap` bytes
+ * of `dest`. The output is complete only if the returned size fits
+ * in `cap`; pass a `cap` of `0` to get the size first.
+ *
+ * Returns the size of the packed list, or `0` if it cannot be
+ * represented (negative components, more than 2^32 entries or bytes).
+ */
+
+SEMVER_API size_t
+semver_pack (const semver_t *arr, size_t n, unsigned char *dest, size_t cap) {
+  const char *str[2], *last[2];
+  size_t len[2], last_len[2], blocks, pos, data, i, p;
+  const semver_t *x;
+  int prev[3] = {0, 0, 0}, f;
+  long d;
+
+  if (n > PACK_MAX) return 0;
+  blocks = (n + SEMVER_PACK_BLOCK - 1) / SEMVER_PACK_BLOCK;
+
+  for (i = 0; i < 4; i++) pack_put(dest, cap, i, (unsigned char) PACK_MAGIC[i]);
+  pack_u32(dest, cap, 4, (unsigned long) n);
+  pack_u32(dest, cap, 8, SEMVER_PACK_BLOCK);
+  data = pos = PACK_HEADER + 4 * blocks;
+
+  for (i = 0; i < n; i++) {
+    x = &arr[i];
+    if (x->major < 0 || x->minor < 0 || x->patch < 0) return 0;
+
+    if (i % SEMVER_PACK_BLOCK == 0) {
+      if (pos - data > PACK_MAX) return 0;
+      pack_u32(dest, cap, PACK_HEADER + 4 * (i / SEMVER_PACK_BLOCK), (unsigned long) (pos - data));
+      prev[0] = prev[1] = prev[2] = 0;
+      last_len[0] = last_len[1] = 0;
+      last[0] = last[1] = NULL;
+    }
+
+    str[0] = x->prerelease && *x->prerelease ? x->prerelease : NULL;
+    str[1] = x->metadata && *x->metadata ? x->metadata : NULL;
+
+    /* Tag: flags and 5 bits in the first byte */
+    d = (long) x->major - prev[0];
+    p = (str[0] ? 1 : 0) | (str[1] ? 2 : 0) | (zigzag(d) & 0x1f) << 2;
+    if (zigzag(d) > 0x1f) {
+      pos = pack_put(dest, cap, pos, (unsigned char) (p | 0x80));
+      pos = pack_varint(dest, cap, pos, zigzag(d) >> 5);
+    } else {
+      pos = pack_put(dest, cap, pos, (unsigned char) p);
+    }
+
+    if (d == 0) {
+      d = (long) x->minor - prev[1];
+      pos = pack_varint(dest, cap, pos, zigzag(d));
+      pos = pack_varint(dest, cap, pos, d == 0
+                        ? zigzag((long) x->patch - prev[2]) : (unsigned long) x->patch);
+    } else {
+      pos = pack_varint(dest, cap, pos, (unsigned long) x->minor);
+      pos = pack_varint(dest, cap, pos, (unsigned long) x->patch);
+    }
+
+    for (f = 0; f < 2; f++) {
+      if (str[f] == NULL) continue;
+      len[f] = strlen(str[f]);
+      for (p = 0; p < len[f] && p < last_len[f] && str[f][p] == last[f][p]; p++);
+      pos = pack_varint(dest, cap, pos, (unsigned long) p);
+      pos = pack_varint(dest, cap, pos, (unsigned long) (len[f] - p));
+      for (; p < len[f]; p++) pos = pack_put(dest, cap, pos, (unsigned char) str[f][p]);
+      last[f] = str[f];
+      last_len[f] = len[f];
+    }
+
+    prev[0] = x->major;
+    prev[1] = x->minor;
+    prev[2] = x->patch;
+  }
+
+  if (pos - data > PACK_MAX) return 0;
+  return pos;
+}
+
+/**
+ * Opens a packed list stored in `len` bytes at `data`, which are
+ * borrowed (and can be mapped from a file) and are never written.
+ * Only the header and block index are checked: entries are decoded
+ * on demand, and decoding a corrupted entry fails.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Not a packed list, or truncated
+ */
+
+SEMVER_API int
+semver_pack_open (semver_pack_t *pack, const void *data, size_t len) {
+  const unsigned char *bytes = (const unsigned char *) data;
+  unsigned long offset, last;
+  size_t blocks, i;
+
+  if (len < PACK_HEADER || memcmp(bytes, PACK_MAGIC, 4) != 0) return -1;
+  pack->data = bytes;
+  pack->len = len;
+  pack->count = pack_u32_get(bytes + 4);
+  pack->block = pack_u32_get(bytes + 8);
+  if (pack->block == 0) return -1;
+
+  blocks = pack_blocks(pack);
+  if (blocks > (len - PACK_HEADER) / 4) return -1;
+
+  for (i = 0, last = 0; i < blocks; i++) {
+    offset = pack_u32_get(bytes + PACK_HEADER + 4 * i);
+    if (offset < last || offset > len - PACK_HEADER - 4 * blocks) return -1;
+    last = offset;
+  }
+
+  return 0;
+}
+
+/**
+ * Decodes the `i`-th version of a packed list, decoding at most one
+ * block. Prerelease and metadata are allocated as in `semver_parse`,
+ * so the version must be released with `semver_free`.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Out of range, corrupted data or memory allocation error
+ */
+
+SEMVER_API int
+semver_unpack (const semver_pack_t *pack, size_t i, semver_t *ver) {
+  struct pack_cursor c;
+  size_t first, k, max[2];
+  char *buf[2];
+  int f;
+
+  if (i >= pack->count) return -1;
+  first = i - i % pack->block;
+
+  /* First pass for the longest strings, then decode them in place */
+  pack_cursor_init(&c, pack, i / pack->block);
+  max[0] = max[1] = 0;
+  for (k = first; k <= i; k++) {
+    if (pack_next(&c)) return -1;
+    for (f = 0; f < 2; f++)
+      if (c.present[f] && c.len[f] > max[f]) max[f] = c.len[f];
+  }
+
+  buf[0] = buf[1] = NULL;
+  for (f = 0; f < 2; f++) {
+    if (c.present[f] && (buf[f] = (char*)mem_alloc(max[f] + 1)) == NULL) {
+      free(buf[0]);
+      return -1;
+    }
+  }
+
+  pack_cursor_init(&c, pack, i / pack->block);
+  for (k = first; k <= i; k++) {
+    pack_next(&c);
+    for (f = 0; f < 2; f++)
+      if (buf[f] && c.present[f])
+        memcpy(buf[f] + c.prefix[f], c.suffix[f], c.len[f] - c.prefix[f]);
+  }
+
+  for (f = 0; f < 2; f++)
+    if (buf[f]) buf[f][c.len[f]] = '\0';
+
+  ver->major = (int) c.v[0];
+  ver->minor = (int) c.v[1];
+  ver->patch = (int) c.v[2];
+  ver->prerelease = buf[0];
+  ver->metadata = buf[1];
+  return 0;
+}
+
+/**
+ * Decodes a whole packed list into the caller owned `out` array,
+ * which must hold `pack->count` versions. As in `semver_parse_batch`,
+ * every string is stored in a single block returned in `block` (NULL
+ * if there are none), released with one `free(*block)`.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Corrupted data or memory allocation error
+ */
+
+SEMVER_API int
+semver_unpack_all (const semver_pack_t *pack, semver_t *out, char **block) {
+  struct pack_cursor c;
+  const char *last[2];
+  char *next, *str[2];
+  size_t i, k, size;
+  int f;
+
+  *block = NULL;
+  for (i = 0, k = 0, size = 0; i < pack->count; i++, k--) {
+    if (k == 0) {
+      pack_cursor_init(&c, pack, i / pack->block);
+      k = pack->block;
+    }
+    if (pack_next(&c)) return -1;
+    for (f = 0; f < 2; f++)
+      if (c.present[f]) size += c.len[f] + 1;
+  }
+
+  if (size && (*block = (char*)mem_alloc(size)) == NULL) return -1;
+  next = *block;
+
+  for (i = 0, k = 0; i < pack->count; i++, k--) {
+    if (k == 0) {
+      pack_cursor_init(&c, pack, i / pack->block);
+      k = pack->block;
+      last[0] = last[1] = NULL;
+    }
+    pack_next(&c);
+    for (f = 0; f < 2; f++) {
+      str[f] = NULL;
+      if (!c.present[f]) continue;
+      str[f] = next;
+      if (c.prefix[f]) memcpy(next, last[f], c.prefix[f]);
+      memcpy(next + c.prefix[f], c.suffix[f], c.len[f] - c.prefix[f]);
+      next[c.len[f]] = '\0';
+      next += c.len[f] + 1;
+      last[f] = str[f];
+    }
+    out[i].major = (int) c.v[0];
+    out[i].minor = (int) c.v[1];
+    out[i].patch = (int) c.v[2];
+    out[i].prerelease = str[0];
+    out[i].metadata = str[1];
+  }
+
+  return 0;
+}
+
+/**
+ * Hashing
+ *
+ * Hashes are consistent with `semver_eq`: build metadata is ignored and
+ * numeric prerelease identifiers are hashed without leading zeros, since
+ * they compare by value.
+ */
+
+#define HASH_MASK 0xffffffffUL
+
+static unsigned long
+hash_word (unsigned long h, unsigned long w) {
+  h = ((h ^ w) * 0x9e3779b1UL) & HASH_MASK;
+  return h ^ (h >> 15);
+}
+
+static unsigned long
+hash_version (int major, int minor, int patch, const char *pr, size_t len) {
+  const char *end, *next;
+  unsigned long h;
+
+  h = hash_word(0x811c9dc5UL, (unsigned int) major);
+  h = hash_word(h, (unsigned int) minor);
+  h = hash_word(h, (unsigned int) patch);
+  if (pr == NULL) return h;
+
+  h = hash_word(h, 1);
+  for (end = pr + len; ; pr = next + 1) {
+    for (next = pr; next < end && *next != DELIMITER[0]; next++);
+    if (is_numeric(pr, next - pr))
+      while (next - pr > 1 && *pr == '0') pr++;
+    for (; pr < next; pr++) h = ((h ^ (unsigned char) *pr) * 0x01000193UL) & HASH_MASK;
+    if (next == end) break;
+    h = hash_word(h, DELIMITER[0]);
+  }
+
+  return hash_word(h, 0);
+}
+
+/**
+ * Hashes a version consistently with `semver_eq`:
+ * equal versions always have the same hash.
+ */
+
+SEMVER_API unsigned long
+semver_hash (const semver_t *x) {
+  return hash_version(x->major, x->minor, x->patch, x->prerelease,
+                      x->prerelease ? strlen(x->prerelease) : 0);
+}
+
+/**
+ * Same as `semver_hash` for version views.
+ */
+
+SEMVER_API unsigned long
+semver_view_hash (const semver_view_t *x) {
+  return hash_version(x->major, x->minor, x->patch,
+                      x->prerelease.len ? x->src + x->prerelease.offset : NULL,
+                      x->prerelease.len);
+}
+
+/**
+ * Hash sets and counters
+ *
+ * Linear probing over a power of two table kept at most 3/4 full.
+ * Empty slots have a zero count. Prereleases are copied, NUL
+ * terminated, into a pool shared by all the entries.
+ */
+
+#define SET_MIN_CAP 16
+#define NO_PRERELEASE ((size_t) -1)
+
+static semver_set_entry_t *
+set_find (const semver_set_t *set, const semver_t *x, unsigned long hash, size_t len) {
+  semver_set_entry_t *e;
+  size_t i, mask;
+
+  if (set->cap == 0) return NULL;
+  mask = set->cap - 1;
+
+  for (i = hash & mask; ; i = (i + 1) & mask) {
+    e = &set->entries[i];
+    if (e->count == 0) return e;
+    if (e->hash == hash && e->major == x->major && e->minor == x->minor && e->patch == x->patch
+        && (e->prerelease == NO_PRERELEASE
+            ? x->prerelease == NULL
+            : x->prerelease && compare_prerelease_n(set->pool + e->prerelease, e->prerelease_len,
+                                                    x->prerelease, len) == 0))
+      return e;
+  }
+}
+
+static int
+set_grow (semver_set_t *set) {
+  semver_set_entry_t *entries, *e;
+  size_t i, j, cap;
+
+  cap = set->cap ? set->cap * 2 : SET_MIN_CAP;
+  entries = (semver_set_entry_t*)mem_alloc(cap * sizeof(*entries));
+  if (entries == NULL) return -1;
+  for (i = 0; i < cap; i++) entries[i].count = 0;
+
+  for (i = 0; i < set->cap; i++) {
+    e = &set->entries[i];
+    if (e->count == 0) continue;
+    for (j = e->hash & (cap - 1); entries[j].count; j = (j + 1) & (cap - 1));
+    entries[j] = *e;
+  }
+
+  free(set->entries);
+  set->entries = entries;
+  set->cap = cap;
+  return 0;
+}
+
+static int
+set_pool_add (semver_set_t *set, const char *str, size_t len) {
+  size_t cap;
+  char *pool;
+
+  if (set->pool_len + len + 1 > set->pool_cap) {
+    cap = set->pool_cap ? set->pool_cap : 256;
+    while (cap < set->pool_len + len + 1) cap *= 2;
+    pool = (char*)mem_alloc(cap);
+    if (pool == NULL) return -1;
+    if (set->pool_len) memcpy(pool, set->pool, set->pool_len);
+    free(set->pool);
+    set->pool = pool;
+    set->pool_cap = cap;
+  }
+
+  memcpy(set->pool + set->pool_len, str, len);
+  set->pool[set->pool_len + len] = '\0';
+  set->pool_len += len + 1;
+  return 0;
+}
+
+/*
+ * Adds n to the count of x, inserting it if needed (sets add 0, their
+ * entries keep a count of 1). Returns 1 if inserted, 0 if found, -1 on
+ * allocation errors.
+ */
+
+static int
+set_add (semver_set_t *set, const semver_t *x, unsigned long n) {
+  semver_set_entry_t *e;
+  unsigned long hash;
+  size_t len;
+
+  len = x->prerelease ? strlen(x->prerelease) : 0;
+  hash = hash_version(x->major, x->minor, x->patch, x->prerelease, len);
+
+  e = set_find(set, x, hash, len);
+  if (e && e->count) {
+    e->count += n;
+    return 0;
+  }
+
+  if ((set->len + 1) * 4 > set->cap * 3) {
+    if (set_grow(set)) return -1;
+    e = set_find(set, x, hash, len);
+  }
+
+  e->prerelease = NO_PRERELEASE;
+  e->prerelease_len = 0;
+  if (x->prerelease) {
+    if (set_pool_add(set, x->prerelease, len)) return -1;
+    e->prerelease = set->pool_len - len - 1;
+    e->prerelease_len = len;
+  }
+
+  e->hash = hash;
+  e->major = x->major;
+  e->minor = x->minor;
+  e->patch = x->patch;
+  e->count = n ? n : 1;
+  set->len++;
+  return 1;
+}
+
+static const semver_set_entry_t *
+set_lookup (const semver_set_t *set, const semver_t *x) {
+  const semver_set_entry_t *e;
+  size_t len;
+
+  len = x->prerelease ? strlen(x->prerelease) : 0;
+  e = set_find(set, x, hash_version(x->major, x->minor, x->patch, x->prerelease, len), len);
+  return e && e->count ? e : NULL;
+}
+
+static int
+set_next (const semver_set_t *set, size_t *pos, semver_t *x, unsigned long *count) {
+  const semver_set_entry_t *e;
+
+  for (; *pos < set->cap; (*pos)++) {
+    e = &set->entries[*pos];
+    if (e->count == 0) continue;
+    x->major = e->major;
+    x->minor = e->minor;
+    x->patch = e->patch;
+    x->prerelease = e->prerelease == NO_PRERELEASE ? NULL : set->pool + e->prerelease;
+    x->metadata = NULL;
+    if (count) *count = e->count;
+    (*pos)++;
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * Initializes an empty set. Nothing is allocated until the first insert.
+ */
+
+SEMVER_API void
+semver_set_init (semver_set_t *set) {
+  memset(set, 0, sizeof(*set));
+}
+
+/**
+ * Inserts a version in the set, copying its prerelease.
+ *
+ * Returns:
+ *
+ * `1` - Inserted
+ * `0` - An equal version was already in the set
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_set_insert (semver_set_t *set, const semver_t *x) {
+  return set_add(set, x, 0);
+}
+
+/**
+ * Returns 1 if an equal version is in the set, 0 otherwise.
+ */
+
+SEMVER_API int
+semver_set_contains (const semver_set_t *set, const semver_t *x) {
+  return set_lookup(set, x) != NULL;
+}
+
+/**
+ * Iterates over the versions in the set, in no particular order.
+ * `pos` must start at 0. Versions borrow their prerelease from the set,
+ * so they must not be freed, and are only valid until the next insert.
+ *
+ * Returns 1 while there are versions left, 0 otherwise.
+ */
+
+SEMVER_API int
+semver_set_next (const semver_set_t *set, size_t *pos, semver_t *x) {
+  return set_next(set, pos, x, NULL);
+}
+
+/**
+ * Free memory owned by a set.
+ */
+
+SEMVER_API void
+semver_set_free (semver_set_t *set) {
+  free(set->entries);
+  free(set->pool);
+  memset(set, 0, sizeof(*set));
+}
+
+/**
+ * Initializes an empty counter.
+ */
+
+SEMVER_API void
+semver_counter_init (semver_counter_t *counter) {
+  semver_set_init(&counter->set);
+}
+
+/**
+ * Adds `n` to the count of a version, which must be at least 1.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_counter_add (semver_counter_t *counter, const semver_t *x, unsigned long n) {
+  if (n == 0) return 0;
+  return set_add(&counter->set, x, n) < 0 ? -1 : 0;
+}
+
+/**
+ * Returns how many times a version was counted.
+ */
+
+SEMVER_API unsigned long
+semver_counter_get (const semver_counter_t *counter, const semver_t *x) {
+  const semver_set_entry_t *e = set_lookup(&counter->set, x);
+  return e ? e->count : 0;
+}
+
+/**
+ * Same as `semver_set_next`, also returning the count of every version.
+ */
+
+SEMVER_API int
+semver_counter_next (const semver_counter_t *counter, size_t *pos, semver_t *x, unsigned long *count) {
+  return set_next(&counter->set, pos, x, count);
+}
+
+/**
+ * Free memory owned by a counter.
+ */
+
+SEMVER_API void
+semver_counter_free (semver_counter_t *counter) {
+  semver_set_free(&counter->set);
+}
+
+/**
+ * Parse cache
+ *
+ * Every entry is a single allocation holding the parsed version, the
+ * input string it is keyed by and its NUL terminated prerelease and
+ * metadata. Invalid strings are cached too, unless longer than
+ * MAX_SIZE. When the ring is full the
+ * CLOCK hand skips (and clears) entries hit since its last pass and
+ * evicts the first one that was not. New entries start referenced, and
+ * the slot returned by the previous call (`last`) is never evicted, so
+ * the results of the last two calls are both alive.
+ */
+
+#ifndef SEMVER_CACHE_SIZE
+#define SEMVER_CACHE_SIZE 1024
+#endif
+
+struct semver_cache_entry_s {
+  semver_t ver;
+  unsigned long hash;
+  size_t len;
+  int valid;
+  int referenced;
+};
+
+#define entry_key(entry) ((char *) ((entry) + 1))
+
+/*
+ * Hashes four bytes at a time, assembled in a fixed order so the
+ * loads do not depend on alignment or byte order.
+ */
+
+static unsigned long
+cache_hash (const char *str, size_t len) {
+  const unsigned char *s = (const unsigned char *) str;
+  unsigned long h, w;
+
+  h = hash_word(0x811c9dc5UL, (unsigned long) len & HASH_MASK);
+  for (; len >= 4; s += 4, len -= 4) {
+    w = (unsigned long) s[0] | (unsigned long) s[1] << 8
+      | (unsigned long) s[2] << 16 | (unsigned long) s[3] << 24;
+    h = hash_word(h, w);
+  }
+  for (w = 0; len; len--) w = w << 8 | *s++;
+  return hash_word(h, w);
+}
+
+static struct semver_cache_entry_s *
+cache_entry (const char *str, size_t len, unsigned long hash) {
+  struct semver_cache_entry_s *entry;
+  semver_view_t view;
+  size_t size = 0;
+  char *block;
+  int valid;
+
+  valid = semver_parse_view(str, len, &view) == 0;
+  if (valid) {
+    size = (view.prerelease.len ? view.prerelease.len + 1 : 0)
+         + (view.metadata.len ? view.metadata.len + 1 : 0);
+  }
+
+  entry = (struct semver_cache_entry_s*)mem_alloc(sizeof(*entry) + len + size);
+  if (entry == NULL) return NULL;
+
+  memcpy(entry_key(entry), str, len);
+  block = entry_key(entry) + len;
+  memset(&entry->ver, 0, sizeof(entry->ver));
+  if (valid) {
+    entry->ver.major = view.major;
+    entry->ver.minor = view.minor;
+    entry->ver.patch = view.patch;
+    if (view.prerelease.len) entry->ver.prerelease = slice_copy(str, view.prerelease, &block);
+    if (view.metadata.len) entry->ver.metadata = slice_copy(str, view.metadata, &block);
+  }
+
+  entry->hash = hash;
+  entry->len = len;
+  entry->valid = valid;
+  entry->referenced = 1;
+  return entry;
+}
+
+static int
+cache_alloc (semver_cache_t *cache) {
+  size_t size;
+
+  for (size = 16; size < cache->cap * 2; size *= 2);
+  cache->entries = (struct semver_cache_entry_s**)mem_alloc(cache->cap * sizeof(*cache->entries));
+  cache->table = (size_t*)mem_calloc(size, sizeof(*cache->table));
+  if (cache->entries == NULL || cache->table == NULL) {
+    free(cache->entries);
+    free(cache->table);
+    cache->entries = NULL;
+    cache->table = NULL;
+    return -1;
+  }
+
+  cache->mask = size - 1;
+  return 0;
+}
+
+/*
+ * Removes the slot from the table, shifting back the entries after it
+ * in the same probe run so lookups never stop at the hole.
+ */
+
+static void
+cache_unlink (semver_cache_t *cache, size_t slot) {
+  size_t i, j, home, mask = cache->mask;
+
+  for (i = cache->entries[slot]->hash & mask; cache->table[i] != slot + 1; i = (i + 1) & mask);
+
+  for (j = i; ; ) {
+    cache->table[i] = 0;
+    do {
+      j = (j + 1) & mask;
+      if (cache->table[j] == 0) return;
+      home = cache->entries[cache->table[j] - 1]->hash & mask;
+    } while (i <= j ? i < home && home <= j : i < home || home <= j);
+    cache->table[i] = cache->table[j];
+    i = j;
+  }
+}
+
+/*
+ * Stores a new entry in `*slot`, evicting another one if the cache is
+ * full. The cache holds at least two slots, so
+ * skipping the last returned one always leaves a victim.
+ */
+
+static int
+cache_insert (semver_cache_t *cache, struct semver_cache_entry_s *entry, size_t *slot) {
+  size_t i;
+
+  if (cache->entries == NULL && cache_alloc(cache)) return -1;
+
+  if (cache->len < cache->cap) {
+    *slot = cache->len++;
+  } else {
+    while (cache->entries[cache->hand]->referenced || cache->hand + 1 == cache->last) {
+      cache->entries[cache->hand]->referenced = 0;
+      cache->hand = (cache->hand + 1) % cache->cap;
+    }
+    *slot = cache->hand;
+    cache->hand = (*slot + 1) % cache->cap;
+    cache_unlink(cache, *slot);
+    free(cache->entries[*slot]);
+    cache->evictions++;
+  }
+
+  cache->entries[*slot] = entry;
+  for (i = entry->hash & cache->mask; cache->table[i]; i = (i + 1) & cache->mask);
+  cache->table[i] = *slot + 1;
+  return 0;
+}
+
+/**
+ * Initializes a cache holding up to `cap` versions (at least two), or
+ * a default number if `cap` is `0`. No memory is allocated until the first parse.
+ */
+
+SEMVER_API void
+semver_cache_init (semver_cache_t *cache, size_t cap) {
+  memset(cache, 0, sizeof(*cache));
+  cache->cap = cap ? cap : SEMVER_CACHE_SIZE;
+  if (cache->cap < 2) cache->cap = 2;
+}
+
+/**
+ * Parses a string as semver expression, reusing the result of a
+ * previous parse of the same string if it is still cached.
+ *
+ * On success `ver` points to a version owned by the cache, which must
+ * not be modified nor freed. It stays valid during the next call on the
+ * same cache too, so the results of the last two calls can be used
+ * together, e.g. compared. On error `ver` is set to NULL.
+ *
+ * Returns:
+ *
+ * `0` - Parsed successfully
+ * `-1` - Parse error, invalid or memory allocation error
+ */
+
+SEMVER_API int
+semver_parse_cached (semver_cache_t *cache, const char *str, const semver_t **ver) {
+  struct semver_cache_entry_s *entry;
+  unsigned long hash;
+  const char *end;
+  size_t i, len, slot;
+
+  /* Overlong strings are never valid: do not hash nor cache them */
+  *ver = NULL;
+  end = (const char *) memchr(str, '\0', MAX_SIZE + 1);
+  if (end == NULL) {
+    cache->misses++;
+    return -1;
+  }
+
+  len = (size_t) (end - str);
+  hash = cache_hash(str, len);
+
+  if (cache->table) {
+    for (i = hash & cache->mask; cache->table[i]; i = (i + 1) & cache->mask) {
+      entry = cache->entries[cache->table[i] - 1];
+      if (entry->hash == hash && entry->len == len
+          && memcmp(entry_key(entry), str, len) == 0) {
+        cache->hits++;
+        cache->last = cache->table[i];
+        entry->referenced = 1;
+        if (!entry->valid) return -1;
+        *ver = &entry->ver;
+        return 0;
+      }
+    }
+  }
+
+  cache->misses++;
+  entry = cache_entry(str, len, hash);
+  if (entry == NULL) return -1;
+  if (cache_insert(cache, entry, &slot)) {
+    free(entry);
+    return -1;
+  }
+  cache->last = slot + 1;
+
+  if (!entry->valid) return -1;
+  *ver = &entry->ver;
+  return 0;
+}
+
+/**
+ * Frees every cached version and the memory owned by the cache,
+ * which can be used again afterwards with the same capacity.
+ */
+
+SEMVER_API void
+semver_cache_free (semver_cache_t *cache) {
+  size_t i;
+  for (i = 0; i < cache->len; i++) free(cache->entries[i]);
+  free(cache->entries);
+  free(cache->table);
+  semver_cache_init(cache, cache->cap);
+}
+
+/**
+ * Intern table
+ *
+ * Slots only go from NULL to an entry, never back, and entries are
+ * immutable once published, so readers need no locks: an acquire load
+ * of a slot sees the whole entry. Writers reserve room in `len` first,
+ * then race to publish with compare-and-swap; a writer losing the race
+ * to an equal string frees its copy and takes the winner's ID.
+ *
+ * Without GCC style atomic builtins the table is not thread safe.
+ */
+
+#ifdef __ATOMIC_ACQUIRE
+#define intern_load(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define intern_cas(p, expected, desired) \
+  __atomic_compare_exchange_n(p, expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define intern_add(p, n) __atomic_fetch_add(p, n, __ATOMIC_RELAXED)
+#define intern_sub(p, n) __atomic_fetch_sub(p, n, __ATOMIC_RELAXED)
+#else
+#define intern_load(p) (*(p))
+#define intern_cas(p, expected, desired) \
+  (*(p) == *(expected) ? (*(p) = (desired), 1) : (*(expected) = *(p), 0))
+#define intern_add(p, n) ((*(p) += (n)) - (n))
+#define intern_sub(p, n) ((*(p) -= (n)) + (n))
+#endif
+
+struct semver_intern_entry_s {
+  semver_t ver;
+  semver_key_t key;
+  int exact;
+  unsigned long hash;
+  size_t len;
+};
+
+static struct semver_intern_entry_s *
+intern_entry (const char *str, size_t len, unsigned long hash) {
+  struct semver_intern_entry_s *entry;
+  semver_view_t view;
+  size_t size;
+  char *block;
+
+  if (semver_parse_view(str, len, &view)) return NULL;
+  size = (view.prerelease.len ? view.prerelease.len + 1 : 0)
+       + (view.metadata.len ? view.metadata.len + 1 : 0);
+
+  entry = (struct semver_intern_entry_s*)mem_alloc(sizeof(*entry) + len + size);
+  if (entry == NULL) return NULL;
+
+  memcpy(entry_key(entry), str, len);
+  block = entry_key(entry) + len;
+  entry->ver.major = view.major;
+  entry->ver.minor = view.minor;
+  entry->ver.patch = view.patch;
+  entry->ver.prerelease = view.prerelease.len ? slice_copy(str, view.prerelease, &block) : NULL;
+  entry->ver.metadata = view.metadata.len ? slice_copy(str, view.metadata, &block) : NULL;
+  entry->exact = semver_view_key(&view, &entry->key);
+  entry->hash = hash;
+  entry->len = len;
+  return entry;
+}
+
+static int
+intern_match (const struct semver_intern_entry_s *entry, const char *str, size_t len, unsigned long hash) {
+  return entry->hash == hash && entry->len == len && memcmp(entry_key(entry), str, len) == 0;
+}
+
+/**
+ * Initializes a table interning up to `cap` distinct strings.
+ * This is the only allocation: the table never grows.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Memory allocation error
+ */
+
+SEMVER_API int
+semver_intern_init (semver_intern_t *table, size_t cap) {
+  size_t size;
+
+  for (size = 16; size < cap * 2; size *= 2);
+  table->slots = (struct semver_intern_entry_s**)mem_calloc(size, sizeof(*table->slots));
+  if (table->slots == NULL) return -1;
+  table->mask = size - 1;
+  table->cap = cap;
+  table->len = 0;
+  return 0;
+}
+
+/**
+ * Interns a version string, storing its ID in `id`. Interning an equal
+ * string, from any thread, always gives the same ID. Safe to call
+ * concurrently with any other intern function but `semver_intern_free`.
+ *
+ * Returns:
+ *
+ * `0` - All was fine!
+ * `-1` - Invalid semver, full table or memory allocation error
+ */
+
+SEMVER_API int
+semver_intern (semver_intern_t *table, const char *str, size_t *id) {
+  struct semver_intern_entry_s *entry, *found;
+  unsigned long hash;
+  size_t i, len;
+
+  len = strlen(str);
+  hash = cache_hash(str, len);
+  entry = NULL;
+
+  for (i = hash & table->mask; ; i = (i + 1) & table->mask) {
+    found = intern_load(&table->slots[i]);
+
+    if (found == NULL) {
+      if (entry == NULL) {
+        if (intern_add(&table->len, 1) >= table->cap) {
+          intern_sub(&table->len, 1);
+          return -1;
+        }
+        entry = intern_entry(str, len, hash);
+        if (entry == NULL) {
+          intern_sub(&table->len, 1);
+          return -1;
+        }
+      }
+      if (intern_cas(&table->slots[i], &found, entry)) {
+        *id = i;
+        return 0;
+      }
+    }
+
+    if (intern_match(found, str, len, hash)) {
+      if (entry) {
+        intern_sub(&table->len, 1);
+        free(entry);
+      }
+      *id = i;
+      return 0;
+    }
+  }
+}
+
+/**
+ * Finds the ID of an already interned string without inserting it.
+ *
+ * Returns:
+ *
+ * `0` - Found
+ * `-1` - The string was not interned
+ */
+
+SEMVER_API int
+semver_intern_find (const semver_intern_t *table, const char *str, size_t *id) {
+  struct semver_intern_entry_s *found;
+  unsigned long hash;
+  size_t i, len;
+
+  len = strlen(str);
+  hash = cache_hash(str, len);
+
+  for (i = hash & table->mask; ; i = (i + 1) & table->mask) {
+    found = intern_load(&table->slots[i]);
+    if (found == NULL) return -1;
+    if (intern_match(found, str, len, hash)) {
+      *id = i;
+      return 0;
+    }
+  }
+}
+
+/**
+ * Returns the version interned with a given ID, shared by every thread,
+ * or NULL if the ID is unused. It must not be modified nor freed.
+ */
+
+SEMVER_API const semver_t *
+semver_intern_get (const semver_intern_t *table, size_t id) {
+  struct semver_intern_entry_s *entry;
+  if (id > table->mask) return NULL;
+  entry = intern_load(&table->slots[id]);
+  return entry ? &entry->ver : NULL;
+}
+
+/**
+ * Copies the packed sort key of an interned version, computed once
+ * when it was interned.
+ *
+ * Returns:
+ *
+ * `1` - Exact key, as `semver_key`
+ * `0` - Ties with an equal key must be resolved with `semver_compare`
+ * `-1` - The ID is unused
+ */
+
+SEMVER_API int
+semver_intern_key (const semver_intern_t *table, size_t id, semver_key_t *key) {
+  struct semver_intern_entry_s *entry;
+  if (id > table->mask) return -1;
+  entry = intern_load(&table->slots[id]);
+  if (entry == NULL) return -1;
+  *key = entry->key;
+  return entry->exact;
+}
+
+/**
+ * Frees the table and every interned version. No other thread may be
+ * using it.
+ */
+
+SEMVER_API void
+semver_intern_free (semver_intern_t *table) {
+  size_t i;
+  if (table->slots) {
+    for (i = 0; i <= table->mask; i++) free(table->slots[i]);
+  }
+  free(table->slots);
+  memset(table, 0, sizeof(*table));
+}
+
+/**
+ * Scanner
+ */
+
+#ifndef SEMVER_SCAN_BUFFER
+#define SEMVER_SCAN_BUFFER 65536
+#endif
+
+/*
+ * Reports every whitespace delimited token in buf[0:len], located at
+ * `base` in the input, with at most `max` of its bytes. Unless `final`
+ * is set, a token reaching the end of the buffer may continue in the
+ * next read and is left unreported, storing where it starts in `rest`.
+ */
+
+static int
+scan_tokens (const char *buf, size_t len, size_t base, int final, size_t max,
+             size_t *rest, semver_scan_fn fn, void *data) {
+  semver_view_t ver;
+  size_t i = 0, start, n;
+  int res;
+
+  for (;;) {
+    while (i < len && is_space(buf[i])) i++;
+    start = i;
+    if (i == len) break;
+    while (i < len && !is_space(buf[i])) i++;
+    if (i == len && !final) break;
+
+    n = i - start < max ? i - start : max;
+    res = semver_parse_view(buf + start, n, &ver)
+      ? fn(NULL, buf + start, n, base + start, data)
+      : fn(&ver, buf + start, n, base + start, data);
+    if (res) return res;
+  }
+
+  *rest = start;
+  return 0;
+}
+
+/**
+ * Scans `len` bytes of `buf` for whitespace delimited versions, calling
+ * `fn` for each token in place, with no copies or allocations. Invalid
+ * tokens are reported with a NULL version and do not stop the scan.
+ *
+ * Returns:
+ *
+ * `0` - The whole buffer was scanned
+ * The non-zero value returned by `fn` when it stopped the scan
+ */
+
+SEMVER_API int
+semver_scan (const char *buf, size_t len, semver_scan_fn fn, void *data) {
+  size_t rest;
+  return scan_tokens(buf, len, 0, 1, (size_t) -1, &rest, fn, data);
+}
+
+/**
+ * Splits `len` bytes of `buf` into `parts` chunks of about the same size
+ * that never cut a token, storing `parts + 1` chunk boundaries in
+ * `bounds`: chunk `i` is `buf[bounds[i]:bounds[i + 1]]`, so chunks can be
+ * scanned independently, for instance by different threads.
+ */
+
+SEMVER_API void
+semver_scan_split (const char *buf, size_t len, size_t parts, size_t *bounds) {
+  size_t i, at;
+
+  bounds[0] = 0;
+  for (i = 1; i < parts; i++) {
+    at = len / parts * i + len % parts * i / parts;
+    if (at < bounds[i - 1]) at = bounds[i - 1];
+    while (at < len && !is_space(buf[at])) at++;
+    bounds[i] = at;
+  }
+  bounds[parts] = len;
+}
+
+/**
+ * Same as `semver_scan`, reading the input from a stream in large
+ * blocks. Tokens and views passed to `fn` point into an internal buffer
+ * and are only valid during the call. Tokens longer than the maximum
+ * version length are reported as invalid with their first
+ * MAX_SIZE + 1 bytes only, wherever the reads split them.
+ *
+ * Returns:
+ *
+ * `0` - The whole stream was scanned
+ * `-1` - Read or memory allocation error
+ * The non-zero value returned by `fn` when it stopped the scan
+ */
+
+SEMVER_API int
+semver_scan_file (FILE *f, semver_scan_fn fn, void *data) {
+  char *buf;
+  size_t keep = 0, base = 0, total, rest, i;
+  int res = 0, eof = 0, skip = 0;
+
+  buf = (char *) mem_alloc(SEMVER_SCAN_BUFFER);
+  if (buf == NULL) return -1;
+
+  while (!eof && res == 0) {
+    total = keep + fread(buf + keep, 1, SEMVER_SCAN_BUFFER - keep, f);
+    if (total < SEMVER_SCAN_BUFFER) {
+      if (ferror(f)) {
+        res = -1;
+        break;
+      }
+      eof = 1;
+    }
+
+    /* Drop the rest of an overlong token */
+    i = 0;
+    if (skip) {
+      while (i < total && !is_space(buf[i])) i++;
+      skip = i == total;
+    }
+
+    res = scan_tokens(buf + i, total - i, base + i, eof, MAX_SIZE + 1, &rest, fn, data);
+    if (res || eof) break;
+
+    rest += i;
+    keep = total - rest;
+    if (keep > MAX_SIZE) {
+      res = fn(NULL, buf + rest, MAX_SIZE + 1, base + rest, data);
+      skip = 1;
+      rest = total;
+      keep = 0;
+    }
+
+    memmove(buf, buf + rest, keep);
+    base += rest;
+  }
+
+  free(buf);
+  return res;
+}
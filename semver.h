@@ -8,6 +8,10 @@
 #ifndef __SEMVER_H
 #define __SEMVER_H
 
+#include <stddef.h>
+#include <stdio.h>
+#include <limits.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -16,6 +20,25 @@ extern "C" {
 #define SEMVER_VERSION "0.2.0"
 #endif
 
+/**
+ * Header-only mode: define SEMVER_IMPLEMENTATION before including
+ * this header to compile the whole library into the including
+ * translation unit as static (inline) functions, letting the compiler
+ * inline comparators into sort and filter loops.
+ */
+
+#ifdef SEMVER_IMPLEMENTATION
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L)
+#define SEMVER_API static inline
+#elif defined(__GNUC__)
+#define SEMVER_API static __inline__
+#else
+#define SEMVER_API static
+#endif
+#else
+#define SEMVER_API
+#endif
+
 /**
  * semver_t struct
  */
@@ -28,78 +51,673 @@ typedef struct semver_version_s {
   char * prerelease;
 } semver_t;
 
+/**
+ * semver_view_t struct
+ *
+ * Borrowed, allocation-free view over a version string.
+ * Prerelease and metadata are (offset, length) pairs into `src`,
+ * a zero length meaning the field is not present.
+ */
+
+typedef struct semver_slice_s {
+  size_t offset;
+  size_t len;
+} semver_slice_t;
+
+typedef struct semver_view_s {
+  int major;
+  int minor;
+  int patch;
+  const char * src;
+  semver_slice_t prerelease;
+  semver_slice_t metadata;
+} semver_view_t;
+
+/**
+ * semver_prerelease_t struct
+ *
+ * Prerelease split into dot separated identifiers. Offsets are
+ * relative to `src`, a NULL `src` meaning no prerelease.
+ */
+
+#ifndef SEMVER_MAX_IDENTIFIERS
+#define SEMVER_MAX_IDENTIFIERS 16
+#endif
+
+typedef struct semver_identifier_s {
+  unsigned long value;
+  unsigned char offset;
+  unsigned char len;
+  unsigned char numeric;
+} semver_identifier_t;
+
+typedef struct semver_prerelease_s {
+  const char * src;
+  size_t count;
+  semver_identifier_t ids[SEMVER_MAX_IDENTIFIERS];
+} semver_prerelease_t;
+
+/**
+ * semver_arena_t struct
+ *
+ * Chunked bump allocator for parsed versions (see `semver_parse_arena`).
+ */
+
+typedef struct semver_arena_s {
+  struct semver_arena_chunk_s * head;
+  struct semver_arena_chunk_s * current;
+  size_t chunk_size;
+} semver_arena_t;
+
+/**
+ * semver_key_t struct
+ *
+ * Order-preserving packed key: major, minor, patch and a prerelease
+ * rank, each stored in (the low 32 bits of) an unsigned word. Keys compare with
+ * `semver_key_compare` in the same order as `semver_compare`.
+ */
+
+#if UINT_MAX >= 0xffffffffUL
+typedef unsigned int semver_word_t;
+#else
+typedef unsigned long semver_word_t;
+#endif
+
+typedef struct semver_key_s {
+  semver_word_t w[4];
+} semver_key_t;
+
+/**
+ * semver_range_t struct
+ *
+ * Compiled range expression: a sorted set of disjoint intervals
+ * between two bounds, each bound being a packed key plus the
+ * prerelease needed to resolve inexact key ties.
+ */
+
+typedef struct semver_bound_s {
+  semver_key_t key;
+  const char * prerelease;
+  size_t prerelease_len;
+  int exact;
+  int inclusive;
+} semver_bound_t;
+
+typedef struct semver_interval_s {
+  semver_bound_t lo;
+  semver_bound_t hi;
+} semver_interval_t;
+
+typedef struct semver_range_s {
+  semver_interval_t * intervals;
+  size_t len;
+  char * src;
+} semver_range_t;
+
+/**
+ * semver_index_t struct
+ *
+ * Static sorted index over a version list. `keys` and `ranks` are
+ * stored in Eytzinger order (1-based), `positions` and `prerelease`
+ * in sorted order.
+ */
+
+typedef struct semver_index_s {
+  size_t len;
+  semver_key_t * keys;
+  size_t * ranks;
+  size_t * positions;
+  const char ** prerelease;
+  char * strings;
+} semver_index_t;
+
+/**
+ * semver_op_t enum
+ *
+ * Comparison operator, decoded once with `semver_op_parse`.
+ */
+
+typedef enum semver_op_e {
+  SEMVER_OP_EQ,
+  SEMVER_OP_GT,
+  SEMVER_OP_GTE,
+  SEMVER_OP_LT,
+  SEMVER_OP_LTE,
+  SEMVER_OP_TILDE,
+  SEMVER_OP_CARET
+} semver_op_t;
+
+/**
+ * semver_set_t struct
+ *
+ * Open addressing hash set of versions, build metadata ignored.
+ * Versions are stored inline, their prereleases in a single string
+ * pool, so entries are never allocated one by one.
+ * `semver_counter_t` also counts how many times each one was added.
+ */
+
+typedef struct semver_set_entry_s {
+  unsigned long hash;
+  unsigned long count;
+  int major;
+  int minor;
+  int patch;
+  size_t prerelease;
+  size_t prerelease_len;
+} semver_set_entry_t;
+
+typedef struct semver_set_s {
+  semver_set_entry_t * entries;
+  size_t cap;
+  size_t len;
+  char * pool;
+  size_t pool_len;
+  size_t pool_cap;
+} semver_set_t;
+
+typedef struct semver_counter_s {
+  semver_set_t set;
+} semver_counter_t;
+
+/**
+ * semver_cache_t struct
+ *
+ * Bounded cache of parsed versions keyed by their input string (see
+ * `semver_parse_cached`). Entries live in a ring of `cap` slots swept
+ * by a CLOCK hand and are found through a linear probing `table` of
+ * slot numbers (plus one, `0` being empty, as for `last`, the slot
+ * returned by the previous call). Counters can be read at any time to
+ * tune `cap`.
+ */
+
+typedef struct semver_cache_s {
+  struct semver_cache_entry_s ** entries;
+  size_t * table;
+  size_t mask;
+  size_t cap;
+  size_t len;
+  size_t hand;
+  size_t last;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+} semver_cache_t;
+
+/**
+ * semver_intern_t struct
+ *
+ * Fixed capacity table interning version strings, shared by threads.
+ * Every string is parsed once into an immutable entry published in a
+ * slot with compare-and-swap; the slot number is its ID.
+ */
+
+typedef struct semver_intern_s {
+  struct semver_intern_entry_s ** slots;
+  size_t mask;
+  size_t cap;
+  size_t len;
+} semver_intern_t;
+
+/**
+ * semver_pack_t struct
+ *
+ * Reader over a packed version list (see `semver_pack`), borrowing
+ * the packed bytes.
+ */
+
+typedef struct semver_pack_s {
+  const unsigned char * data;
+  size_t len;
+  size_t count;
+  size_t block;
+} semver_pack_t;
+
+/**
+ * semver_bitmap_t struct
+ *
+ * Compressed bitmap of version positions (see `semver_index_bitmap`),
+ * made of containers of array or bit set values.
+ */
+
+typedef struct semver_bitmap_s {
+  struct semver_bitmap_container_s * containers;
+  size_t len;
+  size_t cap;
+} semver_bitmap_t;
+
+/**
+ * semver_column_t struct
+ *
+ * Versions stored as one array per sort key word (see `semver_key_t`),
+ * for `semver_satisfies_many`. `prerelease` is only set for versions
+ * whose rank is inexact.
+ */
+
+typedef struct semver_column_s {
+  size_t len;
+  semver_word_t * major;
+  semver_word_t * minor;
+  semver_word_t * patch;
+  semver_word_t * rank;
+  const char ** prerelease;
+  char * strings;
+} semver_column_t;
+
+/**
+ * semver_stats_t struct
+ *
+ * Hot path counters, collected only when the library is compiled with
+ * SEMVER_STATS. With SEMVER_STATS_LATENCY, `latency[k]` also counts the
+ * `semver_parse_view` calls that took from 2^k to 2^(k+1) clock ticks.
+ */
+
+typedef enum semver_stat_e {
+  SEMVER_STAT_PARSE,              /* Strings parsed */
+  SEMVER_STAT_PARSE_INVALID,      /* Strings rejected by validation */
+  SEMVER_STAT_COMPARE,            /* Version comparisons */
+  SEMVER_STAT_PRERELEASE_COMPARE, /* Comparisons of two prereleases */
+  SEMVER_STAT_PRERELEASE_STRING,  /* Identifiers compared as strings */
+  SEMVER_STAT_SATISFIES,          /* Versions checked against an operator */
+  SEMVER_STAT_RANGE_MATCH,        /* Versions checked against a range */
+  SEMVER_STAT_ALLOCS,             /* Heap allocations */
+  SEMVER_STAT_ALLOC_BYTES,        /* Heap bytes allocated */
+  SEMVER_STAT_COUNT
+} semver_stat_t;
+
+#define SEMVER_STATS_BUCKETS 32
+
+typedef struct semver_stats_s {
+  unsigned long count[SEMVER_STAT_COUNT];
+  unsigned long latency[SEMVER_STATS_BUCKETS];
+} semver_stats_t;
+
+/**
+ * semver_scan_fn callback
+ *
+ * Called by `semver_scan` for every token found at byte `offset` of
+ * the input, `ver` being NULL if the token is not a valid version.
+ * Return non-zero to stop scanning.
+ */
+
+typedef int (*semver_scan_fn) (const semver_view_t *ver, const char *token,
+                               size_t len, size_t offset, void *data);
+
 /**
  * Set prototypes
  */
 
-int
+SEMVER_API int
 semver_satisfies (semver_t x, semver_t y, const char *op);
 
-int
+SEMVER_API int
 semver_satisfies_caret (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_satisfies_patch (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_compare (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_compare_version (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_compare_prerelease (semver_t x, semver_t y);
 
-int
+SEMVER_API int
+semver_satisfies_ptr (const semver_t *x, const semver_t *y, const char *op);
+
+SEMVER_API int
+semver_op_parse (const char *str, semver_op_t *op);
+
+SEMVER_API int
+semver_satisfies_op (const semver_t *x, const semver_t *y, semver_op_t op);
+
+SEMVER_API size_t
+semver_satisfies_op_many (const semver_t *arr, size_t n, const semver_t *y,
+                          semver_op_t op, unsigned char *bitmap);
+
+SEMVER_API int
+semver_satisfies_caret_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_satisfies_patch_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_compare_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_compare_version_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_compare_prerelease_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_compare_asc (const void *x, const void *y);
+
+SEMVER_API int
+semver_compare_desc (const void *x, const void *y);
+
+SEMVER_API int
+semver_prerelease_tokenize (const char *str, size_t len, semver_prerelease_t *pr);
+
+SEMVER_API int
+semver_parse_tokens (const char *str, size_t len, semver_view_t *ver, semver_prerelease_t *pr);
+
+SEMVER_API int
+semver_prerelease_compare (const semver_prerelease_t *x, const semver_prerelease_t *y);
+
+SEMVER_API int
 semver_gt (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_gte (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_lt (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_lte (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_eq (semver_t x, semver_t y);
 
-int
+SEMVER_API int
 semver_neq (semver_t x, semver_t y);
 
-int
+SEMVER_API int
+semver_gt_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_gte_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_lt_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_lte_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_eq_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
+semver_neq_ptr (const semver_t *x, const semver_t *y);
+
+SEMVER_API int
 semver_parse (const char *str, semver_t *ver);
 
-int
+SEMVER_API int
 semver_parse_version (const char *str, semver_t *ver);
 
-void
+SEMVER_API int
+semver_parse_batch (const char **strs, size_t n, semver_t *out, int *status, char **block);
+
+SEMVER_API void
+semver_arena_init (semver_arena_t *arena, size_t chunk_size);
+
+SEMVER_API int
+semver_parse_arena (semver_arena_t *arena, const char *str, semver_t *ver);
+
+SEMVER_API void
+semver_arena_reset (semver_arena_t *arena);
+
+SEMVER_API void
+semver_arena_destroy (semver_arena_t *arena);
+
+SEMVER_API int
+semver_parse_view (const char *str, size_t len, semver_view_t *ver);
+
+SEMVER_API int
+semver_scan (const char *buf, size_t len, semver_scan_fn fn, void *data);
+
+SEMVER_API int
+semver_scan_file (FILE *f, semver_scan_fn fn, void *data);
+
+SEMVER_API void
+semver_scan_split (const char *buf, size_t len, size_t parts, size_t *bounds);
+
+SEMVER_API int
+semver_view_compare (const semver_view_t *x, const semver_view_t *y);
+
+SEMVER_API int
+semver_view_compare_prerelease (const semver_view_t *x, const semver_view_t *y);
+
+SEMVER_API int
+semver_view_satisfies (const semver_view_t *x, const semver_view_t *y, const char *op);
+
+SEMVER_API int
+semver_view_satisfies_caret (const semver_view_t *x, const semver_view_t *y);
+
+SEMVER_API int
+semver_view_satisfies_patch (const semver_view_t *x, const semver_view_t *y);
+
+SEMVER_API void
 semver_render (semver_t *x, char *dest);
 
-int
+SEMVER_API size_t
+semver_render_n (const semver_t *x, char *dest, size_t cap);
+
+SEMVER_API size_t
+semver_render_batch (const semver_t *arr, size_t n, char *dest, size_t cap, size_t *offsets);
+
+SEMVER_API int
 semver_numeric (semver_t *x);
 
-void
+SEMVER_API int
+semver_key (const semver_t *x, semver_key_t *key);
+
+SEMVER_API int
+semver_view_key (const semver_view_t *x, semver_key_t *key);
+
+SEMVER_API int
+semver_key_compare (const semver_key_t *x, const semver_key_t *y);
+
+SEMVER_API int
+semver_key_sort (semver_key_t *keys, size_t *perm, size_t n);
+
+SEMVER_API int
+semver_sort (semver_t *arr, size_t n);
+
+SEMVER_API int
+semver_merge (const semver_t *arr, const size_t *bounds, size_t runs, size_t *out);
+
+#ifdef SEMVER_THREADS
+SEMVER_API int
+semver_parse_sort_parallel (const char **strs, size_t n, size_t threads,
+                            semver_t *out, size_t *count, char **block);
+#endif
+
+SEMVER_API int
+semver_range_compile (const char *str, semver_range_t *range);
+
+SEMVER_API int
+semver_range_match (const semver_range_t *range, const semver_t *ver);
+
+SEMVER_API int
+semver_range_match_view (const semver_range_t *range, const semver_view_t *ver);
+
+SEMVER_API void
+semver_range_free (semver_range_t *range);
+
+SEMVER_API int
+semver_range_intersect (const semver_range_t *a, const semver_range_t *b, semver_range_t *out);
+
+SEMVER_API int
+semver_range_union (const semver_range_t *a, const semver_range_t *b, semver_range_t *out);
+
+SEMVER_API int
+semver_range_complement (const semver_range_t *a, semver_range_t *out);
+
+SEMVER_API int
+semver_range_intersects (const semver_range_t *a, const semver_range_t *b);
+
+SEMVER_API int
+semver_range_subset (const semver_range_t *a, const semver_range_t *b);
+
+SEMVER_API int
+semver_index_build (semver_index_t *index, const semver_t *arr, size_t n);
+
+SEMVER_API int
+semver_index_max_satisfying (const semver_index_t *index, const semver_range_t *range, size_t *pos);
+
+SEMVER_API int
+semver_index_min_satisfying (const semver_index_t *index, const semver_range_t *range, size_t *pos);
+
+SEMVER_API size_t
+semver_index_count_satisfying (const semver_index_t *index, const semver_range_t *range);
+
+SEMVER_API void
+semver_index_free (semver_index_t *index);
+
+SEMVER_API int
+semver_index_bitmap (const semver_index_t *index, const semver_range_t *range, semver_bitmap_t *out);
+
+SEMVER_API void
+semver_bitmap_init (semver_bitmap_t *bitmap);
+
+SEMVER_API int
+semver_bitmap_and (const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out);
+
+SEMVER_API int
+semver_bitmap_or (const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out);
+
+SEMVER_API int
+semver_bitmap_andnot (const semver_bitmap_t *a, const semver_bitmap_t *b, semver_bitmap_t *out);
+
+SEMVER_API size_t
+semver_bitmap_cardinality (const semver_bitmap_t *bitmap);
+
+SEMVER_API int
+semver_bitmap_contains (const semver_bitmap_t *bitmap, size_t x);
+
+SEMVER_API size_t
+semver_bitmap_values (const semver_bitmap_t *bitmap, size_t *out);
+
+SEMVER_API void
+semver_bitmap_free (semver_bitmap_t *bitmap);
+
+SEMVER_API int
+semver_column_build (semver_column_t *col, const semver_t *arr, size_t n);
+
+SEMVER_API size_t
+semver_satisfies_many (const semver_column_t *col, const semver_t *y, semver_op_t op,
+                       unsigned char *bitmap);
+
+SEMVER_API size_t
+semver_range_match_many (const semver_column_t *col, const semver_range_t *range,
+                         unsigned char *bitmap);
+
+SEMVER_API void
+semver_column_free (semver_column_t *col);
+
+SEMVER_API void
+semver_stats_snapshot (semver_stats_t *stats);
+
+SEMVER_API void
+semver_stats_reset (void);
+
+SEMVER_API size_t
+semver_pack (const semver_t *arr, size_t n, unsigned char *dest, size_t cap);
+
+SEMVER_API int
+semver_pack_open (semver_pack_t *pack, const void *data, size_t len);
+
+SEMVER_API int
+semver_unpack (const semver_pack_t *pack, size_t i, semver_t *ver);
+
+SEMVER_API int
+semver_unpack_all (const semver_pack_t *pack, semver_t *out, char **block);
+
+SEMVER_API unsigned long
+semver_hash (const semver_t *x);
+
+SEMVER_API unsigned long
+semver_view_hash (const semver_view_t *x);
+
+SEMVER_API void
+semver_set_init (semver_set_t *set);
+
+SEMVER_API int
+semver_set_insert (semver_set_t *set, const semver_t *x);
+
+SEMVER_API int
+semver_set_contains (const semver_set_t *set, const semver_t *x);
+
+SEMVER_API int
+semver_set_next (const semver_set_t *set, size_t *pos, semver_t *x);
+
+SEMVER_API void
+semver_set_free (semver_set_t *set);
+
+SEMVER_API void
+semver_counter_init (semver_counter_t *counter);
+
+SEMVER_API int
+semver_counter_add (semver_counter_t *counter, const semver_t *x, unsigned long n);
+
+SEMVER_API unsigned long
+semver_counter_get (const semver_counter_t *counter, const semver_t *x);
+
+SEMVER_API int
+semver_counter_next (const semver_counter_t *counter, size_t *pos, semver_t *x, unsigned long *count);
+
+SEMVER_API void
+semver_counter_free (semver_counter_t *counter);
+
+SEMVER_API void
+semver_cache_init (semver_cache_t *cache, size_t cap);
+
+SEMVER_API int
+semver_parse_cached (semver_cache_t *cache, const char *str, const semver_t **ver);
+
+SEMVER_API void
+semver_cache_free (semver_cache_t *cache);
+
+SEMVER_API int
+semver_intern_init (semver_intern_t *table, size_t cap);
+
+SEMVER_API int
+semver_intern (semver_intern_t *table, const char *str, size_t *id);
+
+SEMVER_API int
+semver_intern_find (const semver_intern_t *table, const char *str, size_t *id);
+
+SEMVER_API const semver_t *
+semver_intern_get (const semver_intern_t *table, size_t id);
+
+SEMVER_API int
+semver_intern_key (const semver_intern_t *table, size_t id, semver_key_t *key);
+
+SEMVER_API void
+semver_intern_free (semver_intern_t *table);
+
+SEMVER_API void
 semver_bump (semver_t *x);
 
-void
+SEMVER_API void
 semver_bump_minor (semver_t *x);
 
-void
+SEMVER_API void
 semver_bump_patch (semver_t *x);
 
-void
+SEMVER_API void
 semver_free (semver_t *x);
 
-int
+SEMVER_API int
 semver_is_valid (const char *s);
 
-int
+SEMVER_API size_t
+semver_is_valid_batch (const char **strs, size_t n, unsigned char *bitmap);
+
+SEMVER_API int
 semver_clean (char *s);
 
 #ifdef __cplusplus
 }
 #endif
 
+#ifdef SEMVER_IMPLEMENTATION
+#include "semver.c"
+#endif
+
 #endif
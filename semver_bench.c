@@ -0,0 +1,678 @@
+/*
+ * semver_bench.c
+ *
+ * Throughput benchmarks over a generated, npm-like corpus.
+ *
+ * Prints one tab separated line per benchmark: name, ns/op, ops/s and
+ * allocations/op. If a file with previous results is given, a last
+ * column shows the ns/op change against it, in percent.
+ *
+ *   $ make bench
+ *   $ ./bench > baseline.tsv
+ *   $ make bench BASELINE=baseline.tsv
+ *
+ * With SEMVER_THREADS (as built by make), times are measured with the
+ * wall clock instead of the CPU time, and the parallel parse and sort
+ * runs over a larger input with 1 to 8 threads to show its scaling.
+ */
+
+#ifdef SEMVER_THREADS
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Count allocations done by the library */
+
+static unsigned long allocs;
+
+static void *
+bench_malloc (size_t size) {
+#if defined(SEMVER_THREADS) && defined(__ATOMIC_RELAXED)
+  __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+#else
+  allocs++;
+#endif
+  return malloc(size);
+}
+
+#define malloc(size) bench_malloc(size)
+#include "semver.c"
+#include "semver_resolve.c"
+#undef malloc
+
+#define CORPUS_SIZE 4096
+#define BULK_SIZE   (CORPUS_SIZE * 64)
+#define REGISTRY_SIZE 100000
+#define MIN_TIME    0.2
+
+static char *strs[CORPUS_SIZE];
+static semver_t vers[CORPUS_SIZE];
+static semver_view_t views[CORPUS_SIZE];
+static semver_t sorted[CORPUS_SIZE];
+static semver_t unpacked[CORPUS_SIZE];
+static char *buffer;
+static size_t buffer_len;
+static semver_range_t range, other;
+static semver_index_t idx;
+static semver_arena_t arena;
+static semver_set_t set;
+static semver_cache_t cache;
+static semver_intern_t intern;
+static unsigned char *packed;
+static size_t packed_len;
+static semver_pack_t pack;
+static semver_bitmap_t matches, other_matches;
+static semver_column_t column;
+static unsigned char mask[CORPUS_SIZE / 8];
+static char *fixture;
+static size_t fixture_len;
+static semver_registry_t registry;
+#ifdef SEMVER_THREADS
+static const char **bulk;
+static semver_t *bulk_out;
+#endif
+
+static volatile size_t sink;
+
+/**
+ * Corpus generation
+ */
+
+static unsigned long seed = 42;
+
+static unsigned long
+rnd (unsigned long n) {
+  seed = seed * 1103515245UL + 12345UL;
+  return ((seed >> 16) & 0x7fff) % n;
+}
+
+static const char *tags[] = {
+  "alpha", "beta", "rc", "next", "canary", "dev", "pre", "insiders"
+};
+
+/*
+ * Most versions are releases with small numbers, the rest carry
+ * prereleases (short tags, numbered tags or long nightly tags) and
+ * build metadata, like the versions published to npm.
+ */
+
+static size_t
+corpus_version (char *buf) {
+  size_t len;
+  unsigned long kind = rnd(100);
+
+  len = sprintf(buf, "%lu.%lu.%lu",
+                rnd(4) ? rnd(5) : rnd(30), rnd(4) ? rnd(12) : rnd(200), rnd(40));
+
+  if (kind < 8) {
+    len += sprintf(buf + len, "-%s.%lu", tags[rnd(3)], rnd(20));
+  } else if (kind < 12) {
+    len += sprintf(buf + len, "-%s", tags[rnd(8)]);
+  } else if (kind < 15) {
+    len += sprintf(buf + len, "-%s.%lu%04lu.%lx%lx", tags[3 + rnd(5)],
+                   2015 + rnd(10), rnd(1232) + 101, rnd(0x7fff), rnd(0x7fff));
+  }
+
+  if (rnd(100) < 5) {
+    len += sprintf(buf + len, "+build.%lu.sha-%lx", rnd(10000), rnd(0x7fff));
+  }
+
+  return len;
+}
+
+/*
+ * Synthetic registry fixture: every package has four releases, each
+ * depending on up to three packages further in the list. Newer releases
+ * ask for newer dependencies, and a few 2.0.0 releases ask for an old
+ * major of a package that may already be picked at 2.0.0, which the
+ * solver has to backtrack from.
+ */
+
+static const char *registry_versions[] = {"1.0.0", "1.1.0", "1.2.0", "2.0.0"};
+static const char *registry_ranges[][3] = {
+  {"^1.0.0", "^1.0.0", "^1.0.0"},
+  {"^1.0.0", "~1.1.0", ">=1.0.0 <2.0.0-0"},
+  {"^1.1.0", "^1.2.0", "~1.0.0 || ^1.1.0"},
+  {"^2.0.0", ">=1.1.0", "^1.2.0 || ^2.0.0"},
+};
+
+static void
+registry_init (void) {
+  unsigned long p, v, k, dep;
+  char *s;
+
+  fixture = (char *) malloc(REGISTRY_SIZE * 4 * 128);
+  for (p = 0, s = fixture; p < REGISTRY_SIZE; p++) {
+    for (v = 0; v < 4; v++) {
+      s += sprintf(s, "p%lu %s", p, registry_versions[v]);
+      for (k = 0; k < 3 && (dep = p + 1 + rnd(200)) < REGISTRY_SIZE; k++) {
+        s += sprintf(s, "%s p%lu %s", k ? "," : ":", dep,
+                     v == 3 && rnd(16) == 0 ? "^1.0.0" : registry_ranges[v][rnd(3)]);
+      }
+      *s++ = '\n';
+    }
+  }
+  fixture_len = (size_t) (s - fixture);
+
+  semver_registry_init(&registry);
+  semver_registry_parse(&registry, fixture, fixture_len, NULL);
+}
+
+static void
+corpus_init (void) {
+  char buf[256];
+  size_t i, len;
+
+  buffer = (char *) malloc(CORPUS_SIZE * sizeof(buf));
+  buffer_len = 0;
+
+  for (i = 0; i < CORPUS_SIZE; i++) {
+    len = corpus_version(buf);
+    strs[i] = (char *) malloc(len + 1);
+    memcpy(strs[i], buf, len + 1);
+    memcpy(buffer + buffer_len, buf, len);
+    buffer_len += len;
+    buffer[buffer_len++] = '\n';
+
+    semver_parse(strs[i], &vers[i]);
+    semver_parse_view(strs[i], len, &views[i]);
+  }
+
+  semver_range_compile("^1.2.0 || >=2.0.0 <3.0.0-0 || ~4.1", &range);
+  semver_range_compile("~1.4 || ^2.1.0-beta || >=4.0.0", &other);
+  semver_index_build(&idx, vers, CORPUS_SIZE);
+  semver_arena_init(&arena, 0);
+  semver_set_init(&set);
+  semver_cache_init(&cache, CORPUS_SIZE);
+  semver_intern_init(&intern, CORPUS_SIZE);
+
+  memcpy(sorted, vers, sizeof(vers));
+  semver_sort(sorted, CORPUS_SIZE);
+  packed_len = semver_pack(sorted, CORPUS_SIZE, NULL, 0);
+  packed = (unsigned char *) malloc(packed_len);
+  semver_pack(sorted, CORPUS_SIZE, packed, packed_len);
+  semver_pack_open(&pack, packed, packed_len);
+
+  semver_index_bitmap(&idx, &range, &matches);
+  semver_index_bitmap(&idx, &other, &other_matches);
+  semver_column_build(&column, vers, CORPUS_SIZE);
+  registry_init();
+
+#ifdef SEMVER_THREADS
+  bulk = (const char **) malloc(BULK_SIZE * sizeof(*bulk));
+  bulk_out = (semver_t *) malloc(BULK_SIZE * sizeof(*bulk_out));
+  for (i = 0; i < BULK_SIZE; i++) bulk[i] = strs[i % CORPUS_SIZE];
+#endif
+}
+
+static void
+corpus_free (void) {
+  size_t i;
+  for (i = 0; i < CORPUS_SIZE; i++) {
+    semver_free(&vers[i]);
+    free(strs[i]);
+  }
+  free(buffer);
+  semver_range_free(&range);
+  semver_range_free(&other);
+  semver_index_free(&idx);
+  semver_arena_destroy(&arena);
+  semver_set_free(&set);
+  semver_cache_free(&cache);
+  semver_intern_free(&intern);
+  free(packed);
+  semver_bitmap_free(&matches);
+  semver_bitmap_free(&other_matches);
+  semver_column_free(&column);
+  free(fixture);
+  semver_registry_free(&registry);
+#ifdef SEMVER_THREADS
+  free(bulk);
+  free(bulk_out);
+#endif
+}
+
+/**
+ * Benchmarks: every function runs one operation over the i-th corpus
+ * entry and returns the number of operations it did.
+ */
+
+static size_t
+bench_parse (size_t i) {
+  semver_t ver;
+  sink += semver_parse(strs[i], &ver);
+  semver_free(&ver);
+  return 1;
+}
+
+static size_t
+bench_parse_view (size_t i) {
+  semver_view_t ver;
+  sink += semver_parse_view(strs[i], strlen(strs[i]), &ver);
+  return 1;
+}
+
+static size_t
+bench_parse_arena (size_t i) {
+  semver_t ver;
+  if (i == 0) semver_arena_reset(&arena);
+  sink += semver_parse_arena(&arena, strs[i], &ver);
+  return 1;
+}
+
+static size_t
+bench_parse_cached (size_t i) {
+  const semver_t *ver;
+  sink += semver_parse_cached(&cache, strs[i], &ver);
+  return 1;
+}
+
+static size_t
+bench_intern (size_t i) {
+  size_t id;
+  sink += semver_intern(&intern, strs[i], &id) ? 0 : id;
+  return 1;
+}
+
+static size_t
+bench_is_valid (size_t i) {
+  sink += semver_is_valid(strs[i]);
+  return 1;
+}
+
+static size_t
+bench_clean (size_t i) {
+  char buf[256];
+  strcpy(buf, strs[i]);
+  sink += semver_clean(buf);
+  return 1;
+}
+
+static size_t
+bench_compare (size_t i) {
+  sink += semver_compare(vers[i], vers[(i * 7 + 1) % CORPUS_SIZE]);
+  return 1;
+}
+
+static size_t
+bench_compare_ptr (size_t i) {
+  sink += semver_compare_ptr(&vers[i], &vers[(i * 7 + 1) % CORPUS_SIZE]);
+  return 1;
+}
+
+static size_t
+bench_view_compare (size_t i) {
+  sink += semver_view_compare(&views[i], &views[(i * 7 + 1) % CORPUS_SIZE]);
+  return 1;
+}
+
+static size_t
+bench_satisfies (size_t i) {
+  static const char *ops[] = {"^", "~", ">=", "<", "="};
+  sink += semver_satisfies(vers[i], vers[(i * 7 + 1) % CORPUS_SIZE], ops[i % 5]);
+  return 1;
+}
+
+static size_t
+bench_satisfies_op (size_t i) {
+  static const semver_op_t ops[] = {
+    SEMVER_OP_CARET, SEMVER_OP_TILDE, SEMVER_OP_GTE, SEMVER_OP_LT, SEMVER_OP_EQ
+  };
+  sink += semver_satisfies_op(&vers[i], &vers[(i * 7 + 1) % CORPUS_SIZE], ops[i % 5]);
+  return 1;
+}
+
+static size_t
+bench_satisfies_op_many (size_t i) {
+  if (i) return 0;
+  sink += semver_satisfies_op_many(vers, CORPUS_SIZE, &vers[1], SEMVER_OP_CARET, mask);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_satisfies_many (size_t i) {
+  if (i) return 0;
+  sink += semver_satisfies_many(&column, &vers[1], SEMVER_OP_CARET, mask);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_range_match_many (size_t i) {
+  if (i) return 0;
+  sink += semver_range_match_many(&column, &range, mask);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_range_match (size_t i) {
+  sink += semver_range_match(&range, &vers[i]);
+  return 1;
+}
+
+static size_t
+bench_range_intersect (size_t i) {
+  semver_range_t out;
+  (void) i;
+  sink += semver_range_intersect(&range, &other, &out);
+  sink += out.len;
+  semver_range_free(&out);
+  return 1;
+}
+
+static size_t
+bench_range_subset (size_t i) {
+  (void) i;
+  sink += semver_range_subset(&other, &range);
+  return 1;
+}
+
+static size_t
+bench_index_max (size_t i) {
+  size_t pos;
+  (void) i;
+  sink += semver_index_max_satisfying(&idx, &range, &pos);
+  return 1;
+}
+
+static size_t
+bench_index_bitmap (size_t i) {
+  semver_bitmap_t out;
+  if (i) return 0;
+  sink += semver_index_bitmap(&idx, &range, &out);
+  semver_bitmap_free(&out);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_bitmap_and (size_t i) {
+  semver_bitmap_t out;
+  if (i) return 0;
+  sink += semver_bitmap_and(&matches, &other_matches, &out);
+  sink += semver_bitmap_cardinality(&out);
+  semver_bitmap_free(&out);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_hash (size_t i) {
+  sink += semver_hash(&vers[i]);
+  return 1;
+}
+
+static size_t
+bench_set_insert (size_t i) {
+  if (i == 0) {
+    semver_set_free(&set);
+    semver_set_init(&set);
+  }
+  sink += semver_set_insert(&set, &vers[i]);
+  return 1;
+}
+
+static size_t
+bench_render (size_t i) {
+  char buf[512];
+  buf[0] = '\0';
+  semver_render(&vers[i], buf);
+  sink += buf[0];
+  return 1;
+}
+
+static size_t
+bench_render_n (size_t i) {
+  char buf[512];
+  sink += semver_render_n(&vers[i], buf, sizeof(buf));
+  return 1;
+}
+
+static size_t
+bench_sort (size_t i) {
+  if (i) return 0;
+  memcpy(sorted, vers, sizeof(vers));
+  sink += semver_sort(sorted, CORPUS_SIZE);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_qsort (size_t i) {
+  if (i) return 0;
+  memcpy(sorted, vers, sizeof(vers));
+  qsort(sorted, CORPUS_SIZE, sizeof(sorted[0]), semver_compare_asc);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_pack (size_t i) {
+  if (i) return 0;
+  sink += semver_pack(sorted, CORPUS_SIZE, packed, packed_len);
+  return CORPUS_SIZE;
+}
+
+static size_t
+bench_unpack (size_t i) {
+  semver_t ver;
+  sink += semver_unpack(&pack, (i * 7 + 1) % CORPUS_SIZE, &ver);
+  semver_free(&ver);
+  return 1;
+}
+
+static size_t
+bench_unpack_all (size_t i) {
+  char *block;
+  if (i) return 0;
+  sink += semver_unpack_all(&pack, unpacked, &block);
+  free(block);
+  return CORPUS_SIZE;
+}
+
+static int
+bench_scan_fn (const semver_view_t *ver, const char *token, size_t len, size_t offset, void *data) {
+  (void) token; (void) offset; (void) data;
+  sink += ver ? len : 0;
+  return 0;
+}
+
+static size_t
+bench_scan (size_t i) {
+  if (i) return 0;
+  semver_scan(buffer, buffer_len, bench_scan_fn, NULL);
+  return CORPUS_SIZE;
+}
+
+/*
+ * The whole registry is one operation per package: loading it from the
+ * fixture, and resolving the dependencies of the first package, which
+ * needs most of the others.
+ */
+
+static size_t
+bench_registry_parse (size_t i) {
+  semver_registry_t reg;
+  if (i) return 0;
+  semver_registry_init(&reg);
+  sink += semver_registry_parse(&reg, fixture, fixture_len, NULL);
+  semver_registry_free(&reg);
+  return REGISTRY_SIZE;
+}
+
+static size_t
+bench_resolve (size_t i) {
+  semver_resolution_t res;
+  size_t len;
+  if (i) return 0;
+  sink += semver_resolve(&registry, "p0", "*", &res);
+  len = res.len;
+  semver_resolution_free(&res);
+  return len;
+}
+
+#ifdef SEMVER_THREADS
+static size_t
+bench_parallel (size_t i, size_t threads) {
+  char *block;
+  size_t count;
+  if (i) return 0;
+  sink += semver_parse_sort_parallel(bulk, BULK_SIZE, threads, bulk_out, &count, &block);
+  free(block);
+  return BULK_SIZE;
+}
+
+static size_t bench_parallel_1 (size_t i) { return bench_parallel(i, 1); }
+static size_t bench_parallel_2 (size_t i) { return bench_parallel(i, 2); }
+static size_t bench_parallel_4 (size_t i) { return bench_parallel(i, 4); }
+static size_t bench_parallel_8 (size_t i) { return bench_parallel(i, 8); }
+#endif
+
+struct bench {
+  const char *name;
+  size_t (*fn) (size_t i);
+};
+
+static const struct bench benches[] = {
+  {"semver_parse", bench_parse},
+  {"semver_parse_view", bench_parse_view},
+  {"semver_parse_arena", bench_parse_arena},
+  {"semver_parse_cached", bench_parse_cached},
+  {"semver_intern", bench_intern},
+  {"semver_is_valid", bench_is_valid},
+  {"semver_clean", bench_clean},
+  {"semver_compare", bench_compare},
+  {"semver_compare_ptr", bench_compare_ptr},
+  {"semver_view_compare", bench_view_compare},
+  {"semver_satisfies", bench_satisfies},
+  {"semver_satisfies_op", bench_satisfies_op},
+  {"semver_satisfies_op_many", bench_satisfies_op_many},
+  {"semver_satisfies_many", bench_satisfies_many},
+  {"semver_range_match", bench_range_match},
+  {"semver_range_match_many", bench_range_match_many},
+  {"semver_range_intersect", bench_range_intersect},
+  {"semver_range_subset", bench_range_subset},
+  {"semver_index_max_satisfying", bench_index_max},
+  {"semver_index_bitmap", bench_index_bitmap},
+  {"semver_bitmap_and", bench_bitmap_and},
+  {"semver_hash", bench_hash},
+  {"semver_set_insert", bench_set_insert},
+  {"semver_render", bench_render},
+  {"semver_render_n", bench_render_n},
+  {"semver_sort", bench_sort},
+  {"qsort_compare_asc", bench_qsort},
+  {"semver_scan", bench_scan},
+  {"semver_pack", bench_pack},
+  {"semver_unpack", bench_unpack},
+  {"semver_unpack_all", bench_unpack_all},
+  {"semver_registry_parse", bench_registry_parse},
+  {"semver_resolve", bench_resolve},
+#ifdef SEMVER_THREADS
+  {"semver_parse_sort_parallel_1", bench_parallel_1},
+  {"semver_parse_sort_parallel_2", bench_parallel_2},
+  {"semver_parse_sort_parallel_4", bench_parallel_4},
+  {"semver_parse_sort_parallel_8", bench_parallel_8},
+#endif
+};
+
+/**
+ * Runner
+ */
+
+struct result {
+  double ns_op;
+  double ops_s;
+  double allocs_op;
+};
+
+/*
+ * Seconds elapsed since an arbitrary point: CPU time, or wall clock
+ * time when the benchmarks may run several threads.
+ */
+
+static double
+now (void) {
+#ifdef SEMVER_THREADS
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+  return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/*
+ * Runs whole passes over the corpus until at least MIN_TIME seconds
+ * elapsed.
+ */
+
+static void
+run (const struct bench *b, struct result *res) {
+  unsigned long ops = 0, start_allocs;
+  double start, elapsed;
+  size_t i;
+
+  /* Warm up */
+  for (i = 0; i < CORPUS_SIZE; i++) b->fn(i);
+
+  start_allocs = allocs;
+  start = now();
+  do {
+    for (i = 0; i < CORPUS_SIZE; i++) ops += b->fn(i);
+    elapsed = now() - start;
+  } while (elapsed < MIN_TIME);
+
+  res->ns_op = elapsed * 1e9 / ops;
+  res->ops_s = 1e9 / res->ns_op;
+  res->allocs_op = (double) (allocs - start_allocs) / ops;
+}
+
+/*
+ * Finds the ns/op of `name` in a results file, or returns 0.
+ */
+
+static double
+baseline_ns (FILE *f, const char *name) {
+  char line[256], found[128];
+  double ns;
+
+  if (f == NULL) return 0;
+  rewind(f);
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%127s %lf", found, &ns) == 2 && strcmp(found, name) == 0)
+      return ns;
+  }
+  return 0;
+}
+
+int
+main (int argc, char **argv) {
+  struct result res;
+  FILE *baseline = NULL;
+  double base;
+  size_t i;
+
+  if (argc > 1 && (baseline = fopen(argv[1], "r")) == NULL) {
+    fprintf(stderr, "cannot open baseline %s\n", argv[1]);
+    return 1;
+  }
+
+  corpus_init();
+
+  printf("# name\tns_op\tops_s\tallocs_op%s\n", baseline ? "\tdelta_pct" : "");
+  for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+    run(&benches[i], &res);
+    printf("%s\t%.2f\t%.0f\t%.4f", benches[i].name, res.ns_op, res.ops_s, res.allocs_op);
+    if (baseline) {
+      base = baseline_ns(baseline, benches[i].name);
+      if (base > 0) printf("\t%+.1f", (res.ns_op - base) * 100 / base);
+      else printf("\t-");
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  corpus_free();
+  if (baseline) fclose(baseline);
+  return 0;
+}
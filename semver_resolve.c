@@ -0,0 +1,1148 @@
+/*
+ * semver_resolve.c
+ *
+ * Copyright (c) 2015-2017 Tomas Aparicio
+ * MIT licensed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "semver_resolve.h"
+
+/**
+ * Registry
+ *
+ * Releases and dependencies are stored in the order they are added,
+ * the dependencies of a release following each other. Before solving,
+ * `order` groups the releases of every package in ascending version
+ * order, and a package gets a `semver_index_t` over its versions the
+ * first time the solver needs it.
+ */
+
+struct semver_registry_package_s {
+  char * name;
+  unsigned long hash;
+  size_t first;
+  size_t len;
+  semver_index_t index;
+  int indexed;
+};
+
+struct semver_registry_release_s {
+  semver_t version;
+  size_t package;
+  size_t deps;
+  size_t ndeps;
+};
+
+struct semver_registry_dep_s {
+  size_t package;
+  semver_range_t range;
+};
+
+/*
+ * Makes room for one more item in a growable array, returning the
+ * array, possibly moved, or NULL (leaving it untouched) on error.
+ */
+
+static void *
+grow (void *arr, size_t *cap, size_t len, size_t size) {
+  size_t n;
+  void *p;
+
+  if (len < *cap) return arr;
+  n = *cap ? *cap * 2 : 16;
+  p = realloc(arr, n * size);
+  if (p == NULL) return NULL;
+  *cap = n;
+  return p;
+}
+
+static unsigned long
+name_hash (const char *name, size_t len) {
+  unsigned long h = 2166136261UL;
+  while (len--) {
+    h ^= (unsigned char) *name++;
+    h = (h * 16777619UL) & 0xffffffffUL;
+  }
+  return h;
+}
+
+/*
+ * Finds the table slot holding a package name, or the empty slot
+ * where it would be stored.
+ */
+
+static size_t
+registry_slot (const semver_registry_t *reg, const char *name, size_t len, unsigned long hash) {
+  const struct semver_registry_package_s *pkg;
+  size_t i;
+
+  for (i = hash & reg->mask; reg->table[i]; i = (i + 1) & reg->mask) {
+    pkg = &reg->packages[reg->table[i] - 1];
+    if (pkg->hash == hash && strncmp(pkg->name, name, len) == 0 && pkg->name[len] == '\0') break;
+  }
+  return i;
+}
+
+static int
+registry_rehash (semver_registry_t *reg) {
+  size_t *table, size, i, j;
+
+  size = reg->table ? 2 * (reg->mask + 1) : 64;
+  table = (size_t*)calloc(size, sizeof(*table));
+  if (table == NULL) return -1;
+
+  for (i = 0; i < reg->npackages; i++) {
+    for (j = reg->packages[i].hash & (size - 1); table[j]; j = (j + 1) & (size - 1));
+    table[j] = i + 1;
+  }
+
+  free(reg->table);
+  reg->table = table;
+  reg->mask = size - 1;
+  return 0;
+}
+
+/*
+ * Finds a package by name, creating it if it does not exist yet.
+ */
+
+static int
+registry_package (semver_registry_t *reg, const char *name, size_t len, size_t *package) {
+  struct semver_registry_package_s *pkg;
+  unsigned long hash;
+  size_t slot;
+  void *p;
+
+  if (len == 0) return -1;
+  if ((reg->npackages + 1) * 2 > (reg->table ? reg->mask + 1 : 0) && registry_rehash(reg)) return -1;
+
+  hash = name_hash(name, len);
+  slot = registry_slot(reg, name, len, hash);
+  if (reg->table[slot]) {
+    *package = reg->table[slot] - 1;
+    return 0;
+  }
+
+  p = grow(reg->packages, &reg->packages_cap, reg->npackages, sizeof(*reg->packages));
+  if (p == NULL) return -1;
+  reg->packages = (struct semver_registry_package_s*)p;
+
+  pkg = &reg->packages[reg->npackages];
+  memset(pkg, 0, sizeof(*pkg));
+  pkg->name = (char*)malloc(len + 1);
+  if (pkg->name == NULL) return -1;
+  memcpy(pkg->name, name, len);
+  pkg->name[len] = '\0';
+  pkg->hash = hash;
+
+  reg->table[slot] = reg->npackages + 1;
+  *package = reg->npackages++;
+  return 0;
+}
+
+/**
+ * Initializes an empty registry.
+ */
+
+SEMVER_API void
+semver_registry_init (semver_registry_t *reg) {
+  memset(reg, 0, sizeof(*reg));
+}
+
+static int
+registry_add (semver_registry_t *reg, const char *name, size_t len, const char *version, size_t *release) {
+  struct semver_registry_release_s *rel;
+  semver_t ver;
+  size_t package;
+  void *p;
+
+  if (semver_parse(version, &ver)) return -1;
+  p = grow(reg->releases, &reg->releases_cap, reg->nreleases, sizeof(*reg->releases));
+  if (p == NULL || registry_package(reg, name, len, &package)) {
+    if (p) reg->releases = (struct semver_registry_release_s*)p;
+    semver_free(&ver);
+    return -1;
+  }
+  reg->releases = (struct semver_registry_release_s*)p;
+
+  rel = &reg->releases[reg->nreleases];
+  rel->version = ver;
+  rel->package = package;
+  rel->deps = reg->ndeps;
+  rel->ndeps = 0;
+  reg->packages[package].len++;
+
+  free(reg->order);
+  reg->order = NULL;
+  if (release) *release = reg->nreleases;
+  reg->nreleases++;
+  return 0;
+}
+
+static int
+registry_depend (semver_registry_t *reg, const char *name, size_t len, const char *range) {
+  struct semver_registry_dep_s *dep;
+  size_t package;
+  void *p;
+
+  if (reg->nreleases == 0) return -1;
+  p = grow(reg->deps, &reg->deps_cap, reg->ndeps, sizeof(*reg->deps));
+  if (p == NULL) return -1;
+  reg->deps = (struct semver_registry_dep_s*)p;
+
+  dep = &reg->deps[reg->ndeps];
+  if (registry_package(reg, name, len, &package)) return -1;
+  if (semver_range_compile(range, &dep->range)) return -1;
+  dep->package = package;
+
+  reg->ndeps++;
+  reg->releases[reg->nreleases - 1].ndeps++;
+  return 0;
+}
+
+/**
+ * Adds a release of a package, creating the package if needed,
+ * and stores its number in `release` if it is not NULL.
+ *
+ * Returns:
+ *
+ * `0` - Added
+ * `-1` - Empty name, invalid version or memory allocation error
+ */
+
+SEMVER_API int
+semver_registry_add (semver_registry_t *reg, const char *name, const char *version, size_t *release) {
+  return registry_add(reg, name, strlen(name), version, release);
+}
+
+/**
+ * Makes the last added release depend on a version of package `name`
+ * satisfying the `range` expression (see `semver_range_compile`).
+ *
+ * Returns:
+ *
+ * `0` - Added
+ * `-1` - No release yet, empty name, invalid range or memory allocation error
+ */
+
+SEMVER_API int
+semver_registry_depend (semver_registry_t *reg, const char *name, const char *range) {
+  return registry_depend(reg, name, strlen(name), range);
+}
+
+static int
+is_blank (char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static char *
+skip_blanks (char *s) {
+  while (is_blank(*s)) s++;
+  return s;
+}
+
+static char *
+trim_blanks (char *s) {
+  char *end;
+  s = skip_blanks(s);
+  for (end = s + strlen(s); end > s && is_blank(end[-1]); end--);
+  *end = '\0';
+  return s;
+}
+
+/*
+ * Parses one fixture line, NUL terminated and writable.
+ */
+
+static int
+registry_line (semver_registry_t *reg, char *s) {
+  char *name, *version, *dep, *next, *range;
+  size_t name_len;
+  int deps;
+
+  s = skip_blanks(s);
+  if (*s == '\0' || *s == '#') return 0;
+
+  name = s;
+  while (*s && !is_blank(*s) && *s != ':') s++;
+  name_len = (size_t) (s - name);
+  s = skip_blanks(s);
+
+  version = s;
+  while (*s && !is_blank(*s) && *s != ':') s++;
+  if (s == version) return -1;
+  next = skip_blanks(s);
+  if (*next != '\0' && *next != ':') return -1;
+  deps = *next == ':';
+  *s = '\0';
+  if (registry_add(reg, name, name_len, version, NULL)) return -1;
+  if (!deps) return 0;
+
+  for (dep = next + 1; dep; dep = next) {
+    next = strchr(dep, ',');
+    if (next) *next++ = '\0';
+    dep = skip_blanks(dep);
+    for (range = dep; *range && !is_blank(*range); range++);
+    name_len = (size_t) (range - dep);
+    range = trim_blanks(range);
+    if (registry_depend(reg, dep, name_len, *range ? range : "*")) return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * Loads a flat-file fixture into the registry. Every line holds a
+ * release, its package name and version, and optionally a colon
+ * followed by comma separated dependencies, each a package name and a
+ * range (any version if omitted). Blank lines and lines starting with
+ * `#` are skipped.
+ *
+ *   # name version: dependency range, ...
+ *   app 1.0.0: http ^2.1.0, log >=1.2.0 <2.0.0-0
+ *   http 2.1.3: log ~1.4
+ *   log 1.4.2
+ *
+ * On error the number of the failing line (from `1`) is stored in
+ * `line` if it is not NULL, and the lines before it stay loaded.
+ *
+ * Returns:
+ *
+ * `0` - Loaded
+ * `-1` - Syntax, version or range error, or memory allocation error
+ */
+
+SEMVER_API int
+semver_registry_parse (semver_registry_t *reg, const char *buf, size_t len, size_t *line) {
+  const char *end;
+  char *copy = NULL;
+  size_t n, cap = 0, count;
+  void *p;
+
+  for (count = 1; len > 0; count++) {
+    end = (const char *) memchr(buf, '\n', len);
+    n = end ? (size_t) (end - buf) : len;
+
+    if (n + 1 > cap) {
+      p = realloc(copy, n + 1);
+      if (p == NULL) break;
+      copy = (char*)p;
+      cap = n + 1;
+    }
+    memcpy(copy, buf, n);
+    copy[n] = '\0';
+    if (registry_line(reg, copy)) break;
+
+    if (end) n++;
+    buf += n;
+    len -= n;
+  }
+
+  free(copy);
+  if (len == 0) return 0;
+  if (line) *line = count;
+  return -1;
+}
+
+/**
+ * Reads a whole fixture file and loads it as `semver_registry_parse`
+ * does.
+ *
+ * Returns:
+ *
+ * `0` - Loaded
+ * `-1` - Read, syntax, version, range or memory allocation error
+ */
+
+SEMVER_API int
+semver_registry_load (semver_registry_t *reg, FILE *f, size_t *line) {
+  char *buf = NULL;
+  size_t len = 0, cap = 0, n;
+  void *p;
+  int res;
+
+  do {
+    if (len == cap) {
+      p = realloc(buf, cap = cap ? cap * 2 : 65536);
+      if (p == NULL) {
+        free(buf);
+        return -1;
+      }
+      buf = (char*)p;
+    }
+    n = fread(buf + len, 1, cap - len, f);
+    len += n;
+  } while (n > 0);
+
+  res = ferror(f) ? -1 : semver_registry_parse(reg, buf, len, line);
+  free(buf);
+  return res;
+}
+
+/**
+ * Finds a package by name, storing its number in `package`.
+ *
+ * Returns:
+ *
+ * `1` - Found
+ * `0` - No such package
+ */
+
+SEMVER_API int
+semver_registry_find (const semver_registry_t *reg, const char *name, size_t *package) {
+  size_t len = strlen(name), slot;
+
+  if (reg->table == NULL) return 0;
+  slot = registry_slot(reg, name, len, name_hash(name, len));
+  if (reg->table[slot] == 0) return 0;
+  *package = reg->table[slot] - 1;
+  return 1;
+}
+
+/**
+ * Returns the name of a package.
+ */
+
+SEMVER_API const char *
+semver_registry_name (const semver_registry_t *reg, size_t package) {
+  return reg->packages[package].name;
+}
+
+/**
+ * Returns the package of a release.
+ */
+
+SEMVER_API size_t
+semver_registry_package (const semver_registry_t *reg, size_t release) {
+  return reg->releases[release].package;
+}
+
+/**
+ * Returns the version of a release, owned by the registry.
+ */
+
+SEMVER_API const semver_t *
+semver_registry_version (const semver_registry_t *reg, size_t release) {
+  return &reg->releases[release].version;
+}
+
+/**
+ * Frees the memory owned by the registry, which can be used again
+ * afterwards.
+ */
+
+SEMVER_API void
+semver_registry_free (semver_registry_t *reg) {
+  size_t i;
+
+  for (i = 0; i < reg->npackages; i++) {
+    free(reg->packages[i].name);
+    if (reg->packages[i].indexed) semver_index_free(&reg->packages[i].index);
+  }
+  for (i = 0; i < reg->nreleases; i++) semver_free(&reg->releases[i].version);
+  for (i = 0; i < reg->ndeps; i++) semver_range_free(&reg->deps[i].range);
+
+  free(reg->packages);
+  free(reg->releases);
+  free(reg->deps);
+  free(reg->table);
+  free(reg->order);
+  semver_registry_init(reg);
+}
+
+/*
+ * Stable merge sort of release numbers by version.
+ */
+
+static void
+release_sort (const semver_registry_t *reg, size_t *ids, size_t n, size_t *tmp) {
+  const struct semver_registry_release_s *rel = reg->releases;
+  size_t mid, i, j, k;
+
+  if (n < 2) return;
+  mid = n / 2;
+  release_sort(reg, ids, mid, tmp);
+  release_sort(reg, ids + mid, n - mid, tmp);
+
+  for (i = 0, j = mid, k = 0; i < mid && j < n; ) {
+    if (semver_compare_ptr(&rel[ids[j]].version, &rel[ids[i]].version) < 0) tmp[k++] = ids[j++];
+    else tmp[k++] = ids[i++];
+  }
+  while (i < mid) tmp[k++] = ids[i++];
+  while (j < n) tmp[k++] = ids[j++];
+  memcpy(ids, tmp, n * sizeof(*ids));
+}
+
+/*
+ * Groups the releases of every package in `order`, ascending.
+ */
+
+static int
+registry_sort (semver_registry_t *reg) {
+  size_t *tmp, i, first;
+
+  if (reg->order) return 0;
+  reg->order = (size_t*)malloc((reg->nreleases + 1) * sizeof(*reg->order));
+  tmp = (size_t*)malloc((reg->nreleases + 1) * sizeof(*tmp));
+  if (reg->order == NULL || tmp == NULL) {
+    free(reg->order);
+    free(tmp);
+    reg->order = NULL;
+    return -1;
+  }
+
+  for (i = 0, first = 0; i < reg->npackages; i++) {
+    reg->packages[i].first = first;
+    first += reg->packages[i].len;
+    reg->packages[i].len = 0;
+  }
+  for (i = 0; i < reg->nreleases; i++) {
+    struct semver_registry_package_s *pkg = &reg->packages[reg->releases[i].package];
+    reg->order[pkg->first + pkg->len++] = i;
+  }
+  for (i = 0; i < reg->npackages; i++) {
+    release_sort(reg, reg->order + reg->packages[i].first, reg->packages[i].len, tmp);
+    if (reg->packages[i].indexed) {
+      semver_index_free(&reg->packages[i].index);
+      reg->packages[i].indexed = 0;
+    }
+  }
+
+  free(tmp);
+  return 0;
+}
+
+/*
+ * Indexes the versions of a package, in `order` order, so the index
+ * positions are ranks among the releases of the package.
+ */
+
+static int
+registry_index (semver_registry_t *reg, size_t package) {
+  struct semver_registry_package_s *pkg = &reg->packages[package];
+  semver_t *vers;
+  size_t i;
+  int res;
+
+  if (pkg->indexed) return 0;
+  vers = (semver_t*)malloc((pkg->len + 1) * sizeof(*vers));
+  if (vers == NULL) return -1;
+  for (i = 0; i < pkg->len; i++) vers[i] = reg->releases[reg->order[pkg->first + i]].version;
+
+  res = semver_index_build(&pkg->index, vers, pkg->len);
+  free(vers);
+  if (res) return -1;
+  pkg->indexed = 1;
+  return 0;
+}
+
+/**
+ * Resolver
+ *
+ * A backtracking search over packages with conflict-directed
+ * backjumping and nogood learning. Each required package is decided in
+ * turn, taking its highest release allowed by every release already
+ * picked. A release is ruled out, and the facts responsible are added
+ * to the conflict set of the current level, when:
+ *
+ * - it does not satisfy a range required by a picked release, which
+ *   is blamed,
+ * - one of its dependencies is already picked outside of its range,
+ *   the fact blamed being that the dependency is outside of the range
+ *   rather than the exact release picked,
+ * - one of its dependencies, not picked yet, has no release left in
+ *   its range once the ranges already required are applied, which are
+ *   blamed,
+ * - picking it would complete a learned nogood, whose other facts are
+ *   blamed.
+ *
+ * When every release of a package is ruled out, the facts of its
+ * conflict set cannot hold together: the set is learned as a nogood,
+ * and the search jumps back to the latest level it involves, skipping
+ * the decisions in between which played no part in the conflict. An
+ * empty conflict set means that no solution exists.
+ *
+ * As in SAT solvers, the packages of every learned nogood gain
+ * activity, and the most active package waiting is decided first, so
+ * the search keeps to the part of the graph where conflicts happen.
+ * Before any conflict, packages are decided in the order they are
+ * first required.
+ */
+
+struct resolve_req {
+  size_t package;
+  const semver_range_t *range;
+  size_t level;
+  size_t next;
+};
+
+/*
+ * A fact about a picked package: it is `release` or, when `range` is
+ * set, a release outside of `range`.
+ */
+
+struct resolve_lit {
+  size_t package;
+  size_t release;
+  const semver_range_t *range;
+};
+
+struct resolve_level {
+  size_t package;
+  size_t rank;
+  size_t reqs;
+  struct resolve_lit * cs;
+  size_t ncs;
+  size_t cs_cap;
+};
+
+struct resolve_nogood {
+  size_t lits;
+  size_t len;
+  size_t lit;
+  size_t next;
+};
+
+struct resolver {
+  semver_registry_t * reg;
+  semver_resolution_t * out;
+  size_t * assigned;
+  size_t * level;
+  size_t * head;
+  struct resolve_req * reqs;
+  size_t nreqs;
+  size_t reqs_cap;
+  struct resolve_level * levels;
+  size_t nlevels;
+  size_t used;
+  size_t * stamp;
+  size_t epoch;
+  struct resolve_lit * lits;
+  size_t nlits;
+  size_t lits_cap;
+  struct resolve_nogood * occ;
+  size_t nocc;
+  size_t occ_cap;
+  size_t * occ_head;
+  double * activity;
+  double bump;
+  size_t * seq;
+  size_t nseq;
+  size_t * heap;
+  size_t nheap;
+  size_t * pos;
+};
+
+/*
+ * Packages waiting to be decided are kept in a heap, the most active
+ * first, then in the order they were first required.
+ */
+
+static int
+resolve_before (const struct resolver *s, size_t a, size_t b) {
+  if (s->activity[a] != s->activity[b]) return s->activity[a] > s->activity[b];
+  return s->seq[a] < s->seq[b];
+}
+
+static void
+resolve_sift_up (struct resolver *s, size_t i) {
+  size_t package = s->heap[i];
+
+  for (; i > 0 && resolve_before(s, package, s->heap[(i - 1) / 2]); i = (i - 1) / 2) {
+    s->heap[i] = s->heap[(i - 1) / 2];
+    s->pos[s->heap[i]] = i + 1;
+  }
+  s->heap[i] = package;
+  s->pos[package] = i + 1;
+}
+
+static void
+resolve_sift_down (struct resolver *s, size_t i) {
+  size_t package = s->heap[i], child;
+
+  for (; (child = 2 * i + 1) < s->nheap; i = child) {
+    if (child + 1 < s->nheap && resolve_before(s, s->heap[child + 1], s->heap[child])) child++;
+    if (!resolve_before(s, s->heap[child], package)) break;
+    s->heap[i] = s->heap[child];
+    s->pos[s->heap[i]] = i + 1;
+  }
+  s->heap[i] = package;
+  s->pos[package] = i + 1;
+}
+
+static void
+resolve_wait (struct resolver *s, size_t package) {
+  if (s->pos[package] || s->assigned[package]) return;
+  if (!s->seq[package]) s->seq[package] = ++s->nseq;
+  s->heap[s->nheap++] = package;
+  resolve_sift_up(s, s->nheap - 1);
+}
+
+/*
+ * Takes the next package to decide, skipping those no longer required.
+ * Returns `0` if none is left.
+ */
+
+static int
+resolve_next (struct resolver *s, size_t *package) {
+  while (s->nheap > 0) {
+    *package = s->heap[0];
+    s->pos[*package] = 0;
+    if (--s->nheap > 0) {
+      s->heap[0] = s->heap[s->nheap];
+      resolve_sift_down(s, 0);
+    }
+    if (s->head[*package] && !s->assigned[*package]) return 1;
+  }
+  return 0;
+}
+
+static void
+resolve_bump (struct resolver *s, size_t package) {
+  size_t i;
+
+  if ((s->activity[package] += s->bump) > 1e100) {
+    for (i = 0; i < s->reg->npackages; i++) s->activity[i] *= 1e-100;
+    s->bump *= 1e-100;
+  }
+  if (s->pos[package]) resolve_sift_up(s, s->pos[package] - 1);
+}
+
+static int
+resolve_require (struct resolver *s, size_t package, const semver_range_t *range, size_t level) {
+  struct resolve_req *req;
+  void *p;
+
+  p = grow(s->reqs, &s->reqs_cap, s->nreqs, sizeof(*s->reqs));
+  if (p == NULL) return -1;
+  s->reqs = (struct resolve_req*)p;
+
+  req = &s->reqs[s->nreqs];
+  req->package = package;
+  req->range = range;
+  req->level = level;
+  req->next = s->head[package];
+  s->head[package] = ++s->nreqs;
+  resolve_wait(s, package);
+  return 0;
+}
+
+/*
+ * Whether a fact holds, with `release` standing for the pick of its
+ * package, if it is about `package`.
+ */
+
+static int
+resolve_holds (const struct resolver *s, const struct resolve_lit *lit, size_t package, size_t release) {
+  if (lit->package != package) {
+    if (!s->assigned[lit->package]) return 0;
+    release = s->assigned[lit->package] - 1;
+  }
+  if (lit->range == NULL) return release == lit->release;
+  return !semver_range_match(lit->range, &s->reg->releases[release].version);
+}
+
+/*
+ * Starts adding to the conflict set of a level: the packages of its
+ * current facts are marked so `resolve_blame` only looks for
+ * duplicates when it has to.
+ */
+
+static void
+resolve_focus (struct resolver *s, struct resolve_level *l) {
+  size_t i;
+  s->epoch++;
+  for (i = 0; i < l->ncs; i++) s->stamp[l->cs[i].package] = s->epoch;
+}
+
+static int
+resolve_blame (struct resolver *s, struct resolve_level *l, const struct resolve_lit *lit) {
+  size_t i;
+  void *p;
+
+  if (s->stamp[lit->package] == s->epoch) {
+    for (i = 0; i < l->ncs; i++) {
+      if (l->cs[i].package == lit->package && l->cs[i].release == lit->release && l->cs[i].range == lit->range)
+        return 0;
+    }
+  }
+  p = grow(l->cs, &l->cs_cap, l->ncs, sizeof(*l->cs));
+  if (p == NULL) return -1;
+  l->cs = (struct resolve_lit*)p;
+  l->cs[l->ncs++] = *lit;
+  s->stamp[lit->package] = s->epoch;
+  return 0;
+}
+
+/*
+ * Blames the release picked at a level, the root level standing for
+ * the requested range, which always holds.
+ */
+
+static int
+resolve_blame_level (struct resolver *s, struct resolve_level *l, size_t level) {
+  struct resolve_lit lit;
+
+  if (level == 0) return 0;
+  lit.package = s->levels[level].package;
+  lit.release = s->assigned[lit.package] - 1;
+  lit.range = NULL;
+  return resolve_blame(s, l, &lit);
+}
+
+/*
+ * Checks whether a dependency of a release considered at level `l`
+ * leaves its package, not picked yet, without any release satisfying
+ * the ranges already required, blaming the earliest requirement which
+ * rules out each release in its range. Returns `1` if it does, `0` if
+ * it does not and `-1` on memory allocation error.
+ */
+
+static int
+resolve_starved (struct resolver *s, struct resolve_level *l, const struct semver_registry_dep_s *dep) {
+  const semver_registry_t *reg = s->reg;
+  const struct semver_registry_package_s *pkg = &reg->packages[dep->package];
+  const semver_t *version;
+  size_t ncs = l->ncs, i, j, culprit;
+
+  for (i = 0; i < pkg->len; i++) {
+    version = &reg->releases[reg->order[pkg->first + i]].version;
+    if (!semver_range_match(&dep->range, version)) continue;
+
+    culprit = (size_t) -1;
+    for (j = s->head[dep->package]; j; j = s->reqs[j - 1].next) {
+      if (!semver_range_match(s->reqs[j - 1].range, version)) culprit = s->reqs[j - 1].level;
+    }
+    if (culprit == (size_t) -1) {
+      l->ncs = ncs;
+      return 0;
+    }
+    if (resolve_blame_level(s, l, culprit)) return -1;
+  }
+
+  return 1;
+}
+
+/*
+ * Checks whether a release of the package of level `l` is ruled out,
+ * blaming the facts responsible. Returns `1` if it is, `0` if it can
+ * be picked and `-1` on memory allocation error.
+ */
+
+static int
+resolve_ruled_out (struct resolver *s, struct resolve_level *l, size_t release) {
+  const semver_registry_t *reg = s->reg;
+  const struct semver_registry_release_s *rel = &reg->releases[release];
+  const struct semver_registry_dep_s *dep;
+  const struct resolve_nogood *ng;
+  const struct resolve_lit *lit;
+  struct resolve_lit outside;
+  size_t i, j, culprit;
+  int res;
+
+  /* Ranges required by picked releases, blaming the earliest one */
+  culprit = (size_t) -1;
+  for (i = s->head[l->package]; i; i = s->reqs[i - 1].next) {
+    if (!semver_range_match(s->reqs[i - 1].range, &rel->version)) culprit = s->reqs[i - 1].level;
+  }
+  if (culprit != (size_t) -1) return resolve_blame_level(s, l, culprit) ? -1 : 1;
+
+  /* Dependencies already picked outside of their range */
+  for (i = 0; i < rel->ndeps; i++) {
+    dep = &reg->deps[rel->deps + i];
+    if (dep->package == l->package) {
+      if (!semver_range_match(&dep->range, &rel->version)) return 1;
+    } else if (s->assigned[dep->package]) {
+      outside.package = dep->package;
+      outside.release = 0;
+      outside.range = &dep->range;
+      if (resolve_holds(s, &outside, l->package, release)) {
+        return resolve_blame(s, l, &outside) ? -1 : 1;
+      }
+    }
+  }
+
+  /* Dependencies left without a release by the ranges already required */
+  for (i = 0; i < rel->ndeps; i++) {
+    dep = &reg->deps[rel->deps + i];
+    if (dep->package != l->package && !s->assigned[dep->package] && s->head[dep->package]) {
+      res = resolve_starved(s, l, dep);
+      if (res) return res;
+    }
+  }
+
+  /* Learned nogoods this release would complete */
+  for (i = s->occ_head[l->package]; i; i = ng->next) {
+    ng = &s->occ[i - 1];
+    lit = &s->lits[ng->lits];
+    if (!resolve_holds(s, &lit[ng->lit], l->package, release)) continue;
+    for (j = 0; j < ng->len; j++) {
+      if (!resolve_holds(s, &lit[j], l->package, release)) break;
+    }
+    if (j < ng->len) continue;
+    for (j = 0; j < ng->len; j++) {
+      if (lit[j].package != l->package && resolve_blame(s, l, &lit[j])) return -1;
+    }
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * Picks the next release of a level, going down from the last one
+ * tried. Returns `1` if one was picked, `0` if none is left.
+ */
+
+static int
+resolve_pick (struct resolver *s, size_t level) {
+  const semver_registry_t *reg = s->reg;
+  struct resolve_level *l = &s->levels[level];
+  const struct semver_registry_release_s *rel;
+  size_t release, i;
+  int res;
+
+  while (l->rank > 0) {
+    release = reg->order[reg->packages[l->package].first + --l->rank];
+    res = resolve_ruled_out(s, l, release);
+    if (res < 0) return -1;
+    if (res) continue;
+
+    rel = &reg->releases[release];
+    s->assigned[l->package] = release + 1;
+    s->level[l->package] = level;
+    for (i = 0; i < rel->ndeps; i++) {
+      if (resolve_require(s, reg->deps[rel->deps + i].package, &reg->deps[rel->deps + i].range, level))
+        return -1;
+    }
+    s->out->decisions++;
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * Opens a level deciding a package, starting from the highest release
+ * satisfying its earliest requirement.
+ */
+
+static int
+resolve_open (struct resolver *s, size_t package) {
+  struct semver_registry_package_s *pkg = &s->reg->packages[package];
+  const struct resolve_req *req;
+  struct resolve_level *l;
+  size_t pos, i;
+
+  for (i = s->head[package], req = NULL; i; i = req->next) req = &s->reqs[i - 1];
+
+  l = &s->levels[++s->nlevels];
+  if (s->nlevels > s->used) s->used = s->nlevels;
+  l->package = package;
+  l->reqs = s->nreqs;
+  l->ncs = 0;
+  resolve_focus(s, l);
+
+  if (registry_index(s->reg, package)) return -1;
+  l->rank = semver_index_max_satisfying(&pkg->index, req->range, &pos) ? pos + 1 : 0;
+  if (l->rank < pkg->len && resolve_blame_level(s, l, req->level)) return -1;
+  return 0;
+}
+
+static int
+resolve_learn (struct resolver *s, const struct resolve_level *l) {
+  size_t i, start = s->nlits, package;
+  void *p;
+
+  for (i = 0; i < l->ncs; i++) {
+    p = grow(s->lits, &s->lits_cap, s->nlits, sizeof(*s->lits));
+    if (p == NULL) return -1;
+    s->lits = (struct resolve_lit*)p;
+    s->lits[s->nlits++] = l->cs[i];
+  }
+
+  for (i = start; i < s->nlits; i++) {
+    p = grow(s->occ, &s->occ_cap, s->nocc, sizeof(*s->occ));
+    if (p == NULL) return -1;
+    s->occ = (struct resolve_nogood*)p;
+    package = s->lits[i].package;
+    s->occ[s->nocc].lits = start;
+    s->occ[s->nocc].len = l->ncs;
+    s->occ[s->nocc].lit = i - start;
+    s->occ[s->nocc].next = s->occ_head[package];
+    s->occ_head[package] = ++s->nocc;
+  }
+
+  s->out->learned++;
+  return 0;
+}
+
+/*
+ * Handles a level with no release left: learns its conflict set and
+ * jumps back to the latest level it involves, which becomes the
+ * current one. Returns `1` if there is no solution.
+ */
+
+static int
+resolve_backjump (struct resolver *s, size_t *level) {
+  struct resolve_level *l = &s->levels[*level], *h;
+  size_t i, target, k;
+
+  s->out->conflicts++;
+
+  /* The package is only needed because of its earliest requirement */
+  for (i = s->head[l->package], k = 0; i; i = s->reqs[i - 1].next) k = s->reqs[i - 1].level;
+  if (resolve_blame_level(s, l, k)) return -1;
+
+  if (l->ncs == 0) {
+    s->out->failed = l->package;
+    return 1;
+  }
+  if (resolve_learn(s, l)) return -1;
+
+  /* Packages taking part in conflicts are decided earlier from now on */
+  resolve_bump(s, l->package);
+  for (i = 0; i < l->ncs; i++) resolve_bump(s, l->cs[i].package);
+  s->bump *= 1.05;
+
+  for (i = 0, target = 0; i < l->ncs; i++) {
+    if (s->level[l->cs[i].package] > target) target = s->level[l->cs[i].package];
+  }
+  if (*level - target > 1) s->out->backjumps++;
+
+  /* Undo every decision from the target level on */
+  for (k = s->nlevels; k >= target; k--) {
+    s->assigned[s->levels[k].package] = 0;
+    if (k > target) resolve_wait(s, s->levels[k].package);
+  }
+  h = &s->levels[target];
+  while (s->nreqs > h->reqs) {
+    s->nreqs--;
+    s->head[s->reqs[s->nreqs].package] = s->reqs[s->nreqs].next;
+  }
+
+  /* The target release is ruled out by the rest of the conflict set */
+  resolve_focus(s, h);
+  for (i = 0; i < l->ncs; i++) {
+    if (l->cs[i].package != h->package && resolve_blame(s, h, &l->cs[i])) return -1;
+  }
+
+  s->nlevels = target;
+  *level = target;
+  return 0;
+}
+
+static int
+resolve_run (struct resolver *s, size_t root, const semver_range_t *range) {
+  size_t package, level;
+  int res;
+
+  if (resolve_require(s, root, range, 0)) return -1;
+
+  while (resolve_next(s, &package)) {
+    if (resolve_open(s, package)) return -1;
+    level = s->nlevels;
+    while ((res = resolve_pick(s, level)) == 0) {
+      res = resolve_backjump(s, &level);
+      if (res) return res;
+    }
+    if (res < 0) return -1;
+  }
+  return 0;
+}
+
+/**
+ * Picks a release of package `name` satisfying `range`, and of every
+ * package it needs, so that every picked release satisfies all the
+ * dependency ranges of the others, preferring the highest versions of
+ * the packages decided first. Release `out` with
+ * `semver_resolution_free`, whatever the result.
+ *
+ * Returns:
+ *
+ * `0` - Resolved
+ * `1` - No solution (including an unknown package)
+ * `-1` - Invalid range or memory allocation error
+ */
+
+SEMVER_API int
+semver_resolve (semver_registry_t *reg, const char *name, const char *range, semver_resolution_t *out) {
+  struct resolver s;
+  semver_range_t root_range;
+  size_t root, i;
+  int res;
+
+  memset(out, 0, sizeof(*out));
+  out->failed = (size_t) -1;
+  if (semver_range_compile(range, &root_range)) return -1;
+  if (!semver_registry_find(reg, name, &root)) {
+    semver_range_free(&root_range);
+    return 1;
+  }
+  if (registry_sort(reg)) {
+    semver_range_free(&root_range);
+    return -1;
+  }
+
+  memset(&s, 0, sizeof(s));
+  s.reg = reg;
+  s.out = out;
+  s.assigned = (size_t*)calloc(reg->npackages, sizeof(*s.assigned));
+  s.level = (size_t*)calloc(reg->npackages, sizeof(*s.level));
+  s.head = (size_t*)calloc(reg->npackages, sizeof(*s.head));
+  s.levels = (struct resolve_level*)calloc(reg->npackages + 1, sizeof(*s.levels));
+  s.stamp = (size_t*)calloc(reg->npackages + 1, sizeof(*s.stamp));
+  s.occ_head = (size_t*)calloc(reg->npackages + 1, sizeof(*s.occ_head));
+  s.activity = (double*)calloc(reg->npackages + 1, sizeof(*s.activity));
+  s.seq = (size_t*)calloc(reg->npackages + 1, sizeof(*s.seq));
+  s.heap = (size_t*)calloc(reg->npackages + 1, sizeof(*s.heap));
+  s.pos = (size_t*)calloc(reg->npackages + 1, sizeof(*s.pos));
+  s.bump = 1;
+
+  res = -1;
+  if (s.assigned && s.level && s.head && s.levels && s.stamp && s.occ_head
+      && s.activity && s.seq && s.heap && s.pos) {
+    res = resolve_run(&s, root, &root_range);
+  }
+
+  if (res == 0) {
+    out->releases = (size_t*)malloc((s.nlevels + 1) * sizeof(*out->releases));
+    if (out->releases == NULL) res = -1;
+    for (i = 1; res == 0 && i <= s.nlevels; i++) {
+      out->releases[out->len++] = s.assigned[s.levels[i].package] - 1;
+    }
+  }
+
+  if (s.levels) {
+    for (i = 0; i <= s.used; i++) free(s.levels[i].cs);
+  }
+  free(s.assigned);
+  free(s.level);
+  free(s.head);
+  free(s.reqs);
+  free(s.levels);
+  free(s.stamp);
+  free(s.lits);
+  free(s.occ);
+  free(s.occ_head);
+  free(s.activity);
+  free(s.seq);
+  free(s.heap);
+  free(s.pos);
+  semver_range_free(&root_range);
+  return res;
+}
+
+/**
+ * Frees the memory owned by a resolution.
+ */
+
+SEMVER_API void
+semver_resolution_free (semver_resolution_t *res) {
+  free(res->releases);
+  res->releases = NULL;
+  res->len = 0;
+}
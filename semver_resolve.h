@@ -0,0 +1,110 @@
+/*
+ * semver_resolve.h
+ *
+ * Copyright (c) 2015-2017 Tomas Aparicio
+ * MIT licensed
+ */
+
+#ifndef __SEMVER_RESOLVE_H
+#define __SEMVER_RESOLVE_H
+
+#include "semver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * semver_registry_t struct
+ *
+ * Packages, their releases and the dependency ranges of every release,
+ * built with `semver_registry_add` and `semver_registry_depend` or
+ * loaded from a flat-file fixture (see `semver_registry_parse`).
+ * Packages and releases are numbered from `0` in the order they are
+ * first seen, a package being created when first named, even by a
+ * dependency.
+ */
+
+typedef struct semver_registry_s {
+  struct semver_registry_package_s * packages;
+  size_t npackages;
+  size_t packages_cap;
+  struct semver_registry_release_s * releases;
+  size_t nreleases;
+  size_t releases_cap;
+  struct semver_registry_dep_s * deps;
+  size_t ndeps;
+  size_t deps_cap;
+  size_t * table;
+  size_t mask;
+  size_t * order;
+} semver_registry_t;
+
+/**
+ * semver_resolution_t struct
+ *
+ * Result of `semver_resolve`: the release picked for every needed
+ * package, in decision order, and counters of the search. When there
+ * is no solution, `failed` is the package none of whose releases could
+ * be picked.
+ */
+
+typedef struct semver_resolution_s {
+  size_t * releases;
+  size_t len;
+  size_t failed;
+  unsigned long decisions;
+  unsigned long conflicts;
+  unsigned long backjumps;
+  unsigned long learned;
+} semver_resolution_t;
+
+/**
+ * Functions
+ */
+
+SEMVER_API void
+semver_registry_init (semver_registry_t *reg);
+
+SEMVER_API int
+semver_registry_add (semver_registry_t *reg, const char *name, const char *version, size_t *release);
+
+SEMVER_API int
+semver_registry_depend (semver_registry_t *reg, const char *name, const char *range);
+
+SEMVER_API int
+semver_registry_parse (semver_registry_t *reg, const char *buf, size_t len, size_t *line);
+
+SEMVER_API int
+semver_registry_load (semver_registry_t *reg, FILE *f, size_t *line);
+
+SEMVER_API int
+semver_registry_find (const semver_registry_t *reg, const char *name, size_t *package);
+
+SEMVER_API const char *
+semver_registry_name (const semver_registry_t *reg, size_t package);
+
+SEMVER_API size_t
+semver_registry_package (const semver_registry_t *reg, size_t release);
+
+SEMVER_API const semver_t *
+semver_registry_version (const semver_registry_t *reg, size_t release);
+
+SEMVER_API void
+semver_registry_free (semver_registry_t *reg);
+
+SEMVER_API int
+semver_resolve (semver_registry_t *reg, const char *name, const char *range, semver_resolution_t *out);
+
+SEMVER_API void
+semver_resolution_free (semver_resolution_t *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef SEMVER_IMPLEMENTATION
+#include "semver_resolve.c"
+#endif
+
+#endif
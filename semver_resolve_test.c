@@ -0,0 +1,389 @@
+/*
+ * semver_resolve_test.c
+ *
+ * Copyright (c) 2015-2017 Tomas Aparicio
+ * MIT licensed
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "semver_resolve.h"
+
+#define test_start(x) \
+  printf("\n# Test: %s\n", x)  \
+
+#define test_end() \
+  printf("OK\n")  \
+
+/*
+ * Returns the version picked for package `name`, or NULL.
+ */
+
+static const semver_t *
+picked (const semver_registry_t *reg, const semver_resolution_t *res, const char *name) {
+  size_t i;
+  for (i = 0; i < res->len; i++) {
+    if (strcmp(semver_registry_name(reg, semver_registry_package(reg, res->releases[i])), name) == 0)
+      return semver_registry_version(reg, res->releases[i]);
+  }
+  return NULL;
+}
+
+static int
+picked_is (const semver_registry_t *reg, const semver_resolution_t *res, const char *name, const char *version) {
+  const semver_t *ver = picked(reg, res, name);
+  semver_t expected;
+  int eq;
+
+  if (ver == NULL) return 0;
+  semver_parse(version, &expected);
+  eq = semver_eq_ptr(ver, &expected);
+  semver_free(&expected);
+  return eq;
+}
+
+static int
+load (semver_registry_t *reg, const char *fixture) {
+  semver_registry_init(reg);
+  return semver_registry_parse(reg, fixture, strlen(fixture), NULL);
+}
+
+void
+test_registry() {
+  test_start("semver_registry");
+
+  const char *fixture =
+    "# name version: dependency range, ...\n"
+    "app 1.0.0: http ^2.1.0, log >=1.2.0 <2.0.0-0\n"
+    "\n"
+    "  http 2.1.3:log ~1.4 , util\r\n"
+    "log 1.4.2\n"
+    "log 1.3.0-beta.1+build";
+  semver_registry_t reg;
+  size_t pkg, line, release;
+  FILE *f;
+
+  assert(load(&reg, fixture) == 0);
+  assert(reg.npackages == 4 && reg.nreleases == 4 && reg.ndeps == 4);
+  assert(semver_registry_find(&reg, "log", &pkg) == 1 && pkg == 2);
+  assert(strcmp(semver_registry_name(&reg, pkg), "log") == 0);
+  assert(semver_registry_find(&reg, "util", &pkg) == 1);
+  assert(semver_registry_find(&reg, "lo", &pkg) == 0);
+  assert(semver_registry_package(&reg, 3) == 2);
+  assert(strcmp(semver_registry_version(&reg, 3)->prerelease, "beta.1") == 0);
+
+  assert(semver_registry_add(&reg, "util", "0.1.0", &release) == 0 && release == 4);
+  assert(semver_registry_depend(&reg, "log", "^1.0.0") == 0);
+  assert(semver_registry_add(&reg, "util", "v0.1", &release) == -1);
+  assert(semver_registry_depend(&reg, "log", "^^1") == -1);
+  assert(semver_registry_add(&reg, "", "1.0.0", NULL) == -1);
+  semver_registry_free(&reg);
+  assert(reg.npackages == 0 && reg.nreleases == 0);
+  assert(semver_registry_find(&reg, "log", &pkg) == 0);
+
+  /* Errors report the failing line, the ones before stay loaded */
+  semver_registry_init(&reg);
+  assert(semver_registry_parse(&reg, "a 1.0.0\nb\n", 10, &line) == -1 && line == 2);
+  assert(reg.nreleases == 1);
+  assert(semver_registry_parse(&reg, "a 1.0.0 2.0.0", 13, &line) == -1 && line == 1);
+  assert(semver_registry_parse(&reg, "a 1.0.0: b ^1, , c", 18, &line) == -1 && line == 1);
+  assert(semver_registry_parse(&reg, "\n\nb 1.0.0: a ^^1", 16, &line) == -1 && line == 3);
+  semver_registry_free(&reg);
+
+  f = tmpfile();
+  assert(f != NULL);
+  fputs(fixture, f);
+  rewind(f);
+  assert(semver_registry_load(&reg, f, &line) == 0);
+  assert(reg.nreleases == 4);
+  fclose(f);
+  semver_registry_free(&reg);
+
+  test_end();
+}
+
+void
+test_resolve() {
+  test_start("semver_resolve");
+
+  semver_registry_t reg;
+  semver_resolution_t res;
+
+  /* Highest versions allowed by every range */
+  assert(load(&reg,
+    "app 1.0.0: a ^1.0.0, b *\n"
+    "a 1.0.0\n"
+    "a 1.2.0: b <2.0.0\n"
+    "a 2.0.0\n"
+    "b 1.0.0\n"
+    "b 1.5.0\n"
+    "b 2.0.0\n") == 0);
+  assert(semver_resolve(&reg, "app", "*", &res) == 0);
+  assert(res.len == 3);
+  assert(picked_is(&reg, &res, "app", "1.0.0"));
+  assert(picked_is(&reg, &res, "a", "1.2.0"));
+  assert(picked_is(&reg, &res, "b", "1.5.0"));
+  assert(res.conflicts == 0);
+  semver_resolution_free(&res);
+
+  /* Packages not needed are not picked */
+  assert(semver_resolve(&reg, "a", "^2", &res) == 0);
+  assert(res.len == 1 && picked_is(&reg, &res, "a", "2.0.0"));
+  semver_resolution_free(&res);
+
+  assert(semver_resolve(&reg, "a", "^3", &res) == 1);
+  assert(strcmp(semver_registry_name(&reg, res.failed), "a") == 0);
+  semver_resolution_free(&res);
+  assert(semver_resolve(&reg, "nope", "*", &res) == 1);
+  semver_resolution_free(&res);
+  assert(semver_resolve(&reg, "a", ">>1", &res) == -1);
+  semver_resolution_free(&res);
+
+  semver_registry_free(&reg);
+
+  /* foo 1.1.0 needs a bar the root already rules out: it is skipped */
+  assert(load(&reg,
+    "root 1.0.0: foo ^1.0.0, bar ^1.0.0\n"
+    "foo 1.0.0\n"
+    "foo 1.1.0: bar ^2.0.0\n"
+    "bar 1.0.0\n"
+    "bar 2.0.0\n") == 0);
+  assert(semver_resolve(&reg, "root", "*", &res) == 0);
+  assert(picked_is(&reg, &res, "foo", "1.0.0"));
+  assert(picked_is(&reg, &res, "bar", "1.0.0"));
+  assert(res.conflicts == 0);
+  semver_resolution_free(&res);
+  semver_registry_free(&reg);
+
+  /* Picking foo 1.1.0 leads to a conflict on baz: foo goes back to 1.0.0 */
+  assert(load(&reg,
+    "root 1.0.0: foo ^1.0.0, bar ^1.0.0\n"
+    "foo 1.0.0\n"
+    "foo 1.1.0: baz ^2.0.0\n"
+    "bar 1.0.0: baz ^1.0.0\n"
+    "baz 1.0.0\n"
+    "baz 2.0.0\n") == 0);
+  assert(semver_resolve(&reg, "root", "*", &res) == 0);
+  assert(picked_is(&reg, &res, "foo", "1.0.0"));
+  assert(picked_is(&reg, &res, "baz", "1.0.0"));
+  assert(res.conflicts == 1 && res.learned == 1);
+  semver_resolution_free(&res);
+  semver_registry_free(&reg);
+
+  /* No solution: the conflict goes back to the root */
+  assert(load(&reg,
+    "app 1.0.0: a ^1\n"
+    "a 1.0.0: b ^2\n"
+    "a 1.1.0: b ^2, c ^1\n"
+    "b 1.0.0\n"
+    "c 1.0.0\n") == 0);
+  assert(semver_resolve(&reg, "app", "*", &res) == 1);
+  assert(strcmp(semver_registry_name(&reg, res.failed), "app") == 0);
+  assert(res.learned > 0);
+  semver_resolution_free(&res);
+  semver_registry_free(&reg);
+
+  test_end();
+}
+
+void
+test_resolve_backjump() {
+  test_start("semver_resolve_backjump");
+
+  semver_registry_t reg;
+  semver_resolution_t res;
+  char line[64];
+  int i;
+
+  /*
+   * `a` is decided first, then 20 packages with two releases each that
+   * play no part in the conflict, then `z`, which needs the other `a`.
+   * Backtracking through the 2^20 combinations in between is avoided
+   * by jumping straight back to `a`: they are only decided twice.
+   */
+  semver_registry_init(&reg);
+  assert(semver_registry_add(&reg, "root", "1.0.0", NULL) == 0);
+  assert(semver_registry_depend(&reg, "a", "*") == 0);
+  for (i = 0; i < 20; i++) {
+    sprintf(line, "p%d", i);
+    assert(semver_registry_depend(&reg, line, "*") == 0);
+  }
+  assert(semver_registry_depend(&reg, "z", "*") == 0);
+  assert(semver_registry_add(&reg, "a", "1.0.0", NULL) == 0);
+  assert(semver_registry_add(&reg, "a", "2.0.0", NULL) == 0);
+  for (i = 0; i < 20; i++) {
+    sprintf(line, "p%d", i);
+    assert(semver_registry_add(&reg, line, "1.0.0", NULL) == 0);
+    assert(semver_registry_add(&reg, line, "2.0.0", NULL) == 0);
+  }
+  assert(semver_registry_add(&reg, "z", "1.0.0", NULL) == 0);
+  assert(semver_registry_depend(&reg, "a", "^1") == 0);
+
+  assert(semver_resolve(&reg, "root", "*", &res) == 0);
+  assert(res.len == 23);
+  assert(picked_is(&reg, &res, "a", "1.0.0"));
+  assert(picked_is(&reg, &res, "z", "1.0.0"));
+  for (i = 0; i < 20; i++) {
+    sprintf(line, "p%d", i);
+    assert(picked_is(&reg, &res, line, "2.0.0"));
+  }
+  assert(res.conflicts == 1 && res.backjumps == 1);
+  assert(res.decisions == 44);
+  semver_resolution_free(&res);
+  semver_registry_free(&reg);
+
+  test_end();
+}
+
+/*
+ * Random registries of a few packages, checked against an exhaustive
+ * search over every combination of picked releases.
+ */
+
+#define RANDOM_PACKAGES 6
+#define RANDOM_RELEASES 3
+#define RANDOM_DEPS 2
+
+struct random_release {
+  int version;
+  int ndeps;
+  int dep[RANDOM_DEPS];
+  int range[RANDOM_DEPS];
+};
+
+static const char *random_versions[] = {"1.0.0", "1.1.0", "2.0.0", "2.1.0-rc.1", "2.1.0"};
+static const char *random_ranges[] = {
+  "^1.0.0", "^2.0.0", "~1.1.0", ">=1.1.0", "<2.0.0", "*", "2.1.0", ">=2.1.0-0", "1.0.0 || 2.0.0"
+};
+
+static unsigned long seed = 7;
+
+static int
+rnd (int n) {
+  seed = seed * 1103515245UL + 12345UL;
+  return (int) (((seed >> 16) & 0x7fff) % (unsigned long) n);
+}
+
+static int
+random_match (semver_range_t *ranges, int range, int version) {
+  semver_t ver;
+  int res;
+  semver_parse(random_versions[version], &ver);
+  res = semver_range_match(&ranges[range], &ver);
+  semver_free(&ver);
+  return res;
+}
+
+/*
+ * Checks a pick (release + 1 per package, 0 if not picked).
+ */
+
+static int
+random_valid (struct random_release rel[][RANDOM_RELEASES], const int *pick,
+              semver_range_t *ranges, int root_range) {
+  const struct random_release *r;
+  int p, d, q;
+
+  if (pick[0] == 0 || !random_match(ranges, root_range, rel[0][pick[0] - 1].version)) return 0;
+  for (p = 0; p < RANDOM_PACKAGES; p++) {
+    if (pick[p] == 0) continue;
+    r = &rel[p][pick[p] - 1];
+    for (d = 0; d < r->ndeps; d++) {
+      q = r->dep[d];
+      if (pick[q] == 0 || !random_match(ranges, r->range[d], rel[q][pick[q] - 1].version)) return 0;
+    }
+  }
+  return 1;
+}
+
+static int
+random_search (struct random_release rel[][RANDOM_RELEASES], const int *nrel, int *pick, int p,
+               semver_range_t *ranges, int root_range) {
+  if (p == RANDOM_PACKAGES) return random_valid(rel, pick, ranges, root_range);
+  for (pick[p] = 0; pick[p] <= nrel[p]; pick[p]++) {
+    if (random_search(rel, nrel, pick, p + 1, ranges, root_range)) return 1;
+  }
+  return 0;
+}
+
+void
+test_resolve_random() {
+  test_start("semver_resolve_random");
+
+  struct random_release rel[RANDOM_PACKAGES][RANDOM_RELEASES];
+  semver_range_t ranges[sizeof(random_ranges) / sizeof(random_ranges[0])];
+  int nranges = sizeof(ranges) / sizeof(ranges[0]);
+  int nrel[RANDOM_PACKAGES], pick[RANDOM_PACKAGES];
+  semver_registry_t reg;
+  semver_resolution_t res;
+  char name[8];
+  size_t i;
+  int round, p, r, d, v, root_range, found, solved = 0, failed = 0;
+
+  for (r = 0; r < nranges; r++) assert(semver_range_compile(random_ranges[r], &ranges[r]) == 0);
+
+  for (round = 0; round < 2000; round++) {
+    semver_registry_init(&reg);
+    for (p = 0; p < RANDOM_PACKAGES; p++) {
+      sprintf(name, "p%d", p);
+      nrel[p] = 1 + rnd(RANDOM_RELEASES);
+      for (r = 0, v = rnd(2); r < nrel[p]; r++, v += 1 + rnd(2)) {
+        rel[p][r].version = v % 5;
+        rel[p][r].ndeps = rnd(RANDOM_DEPS + 1);
+        assert(semver_registry_add(&reg, name, random_versions[v % 5], NULL) == 0);
+        for (d = 0; d < rel[p][r].ndeps; d++) {
+          rel[p][r].dep[d] = rnd(RANDOM_PACKAGES);
+          rel[p][r].range[d] = rnd(nranges);
+          sprintf(name, "p%d", rel[p][r].dep[d]);
+          assert(semver_registry_depend(&reg, name, random_ranges[rel[p][r].range[d]]) == 0);
+        }
+        sprintf(name, "p%d", p);
+      }
+    }
+
+    root_range = rnd(nranges);
+    found = random_search(rel, nrel, pick, 0, ranges, root_range);
+    assert(semver_resolve(&reg, "p0", random_ranges[root_range], &res) == !found);
+
+    if (found) {
+      /* Map the solution back to release numbers within packages */
+      for (p = 0; p < RANDOM_PACKAGES; p++) pick[p] = 0;
+      for (i = 0; i < res.len; i++) {
+        p = atoi(semver_registry_name(&reg, semver_registry_package(&reg, res.releases[i])) + 1);
+        assert(pick[p] == 0);
+        for (r = 0; r < nrel[p]; r++) {
+          semver_t ver;
+          semver_parse(random_versions[rel[p][r].version], &ver);
+          if (semver_eq_ptr(&ver, semver_registry_version(&reg, res.releases[i]))) pick[p] = r + 1;
+          semver_free(&ver);
+        }
+        assert(pick[p] != 0);
+      }
+      assert(random_valid(rel, pick, ranges, root_range));
+      solved++;
+    } else {
+      failed++;
+    }
+
+    semver_resolution_free(&res);
+    semver_registry_free(&reg);
+  }
+
+  /* Both outcomes are well represented */
+  assert(solved > 200 && failed > 200);
+  for (r = 0; r < nranges; r++) semver_range_free(&ranges[r]);
+
+  test_end();
+}
+
+int
+main() {
+  test_registry();
+  test_resolve();
+  test_resolve_backjump();
+  test_resolve_random();
+
+  return 0;
+}
@@ -174,6 +174,336 @@ test_parse_prerelerease_metadata() {
   test_end();
 }
 
+void
+test_parse_invalid() {
+  test_start("parse_invalid");
+
+  char * invalid[] = {
+    "", "1.", "1..2", "1.2.", ".1.2", "1.2.3.4", "v1.2.3", "01.2.3", "1.02.3",
+    "1.2.03", "1.2.3-", "1.2.3+", "1.2.3-01", "1.2.3-alpha..1", "1.2.3-alpha.",
+    "1.2.3+build.", "1.2.3+build+1", "1.2.3-be$ta", "1.2.3 ", "2147483648.0.0",
+    "1.9007199254740992.0", "1.2.99999999999999999999", "1.2.3a", "1.2.3-0123",
+  };
+  char * valid[] = {
+    "0.0.0", "1.0.0-0", "1.0.0-0a", "1.0.0-00a", "1.0.0-x-y-z.-", "1.0.0+01",
+    "1.0.0-alpha+001", "1.0.0+21AF26D3--117B344092BD", "2147483647.0.0",
+    "12345678.123456789.1234", "1.0.0-123456789012345678901234567890",
+  };
+
+  size_t i;
+  for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    semver_t ver = {0};
+    assert(semver_parse(invalid[i], &ver) == -1);
+    assert(ver.prerelease == NULL);
+    assert(ver.metadata == NULL);
+  }
+
+  for (i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+    semver_t ver = {0};
+    assert(semver_parse(valid[i], &ver) == 0);
+    semver_free(&ver);
+  }
+
+  semver_t ver = {0};
+  assert(semver_parse_version("1.2.3", &ver) == 0);
+  assert(ver.major == 1 && ver.minor == 2 && ver.patch == 3);
+  assert(semver_parse_version("1.2.3-beta", &ver) == -1);
+  assert(semver_parse_version("12345678.123456789.1234", &ver) == 0);
+  assert(ver.major == 12345678 && ver.minor == 123456789 && ver.patch == 1234);
+
+  test_end();
+}
+
+void
+test_parse_batch() {
+  test_start("parse_batch");
+
+  const char *strs[] = {
+    "1.2.3", "1.2.3-beta.1", "invalid", "2.0.0+build.7", NULL, "3.1.4-rc.2+exp.sha",
+  };
+  semver_t out[6];
+  int status[6];
+  char *block;
+
+  int error = semver_parse_batch(strs, 6, out, status, &block);
+
+  assert(error == 0);
+  assert(block != NULL);
+  assert(status[0] == 0 && status[1] == 0 && status[2] == -1);
+  assert(status[3] == 0 && status[4] == -1 && status[5] == 0);
+
+  assert(out[0].major == 1 && out[0].minor == 2 && out[0].patch == 3);
+  assert(out[0].prerelease == NULL && out[0].metadata == NULL);
+  assert(strcmp(out[1].prerelease, "beta.1") == 0);
+  assert(out[1].metadata == NULL);
+  assert(out[2].major == 0 && out[2].prerelease == NULL);
+  assert(out[3].major == 2 && strcmp(out[3].metadata, "build.7") == 0);
+  assert(out[5].patch == 4);
+  assert(strcmp(out[5].prerelease, "rc.2") == 0);
+  assert(strcmp(out[5].metadata, "exp.sha") == 0);
+
+  /* All strings share one block */
+  assert(out[1].prerelease == block);
+  free(block);
+
+  /* Status is optional and no block is needed without strings */
+  error = semver_parse_batch(strs, 1, out, NULL, &block);
+  assert(error == 0);
+  assert(block == NULL);
+  assert(out[0].patch == 3);
+
+  test_end();
+}
+
+void
+test_parse_arena() {
+  test_start("parse_arena");
+
+  semver_arena_t arena;
+  semver_t ver, ver2, ver3;
+  char *first;
+
+  /* Tiny chunks to exercise chunk chaining */
+  semver_arena_init(&arena, 16);
+
+  assert(semver_parse_arena(&arena, "1.2.3", &ver) == 0);
+  assert(arena.head == NULL);
+  assert(ver.prerelease == NULL && ver.metadata == NULL);
+
+  assert(semver_parse_arena(&arena, "1.2.3-beta.1+build.5", &ver) == 0);
+  assert(ver.major == 1 && ver.minor == 2 && ver.patch == 3);
+  assert(strcmp(ver.prerelease, "beta.1") == 0);
+  assert(strcmp(ver.metadata, "build.5") == 0);
+  first = ver.prerelease;
+
+  assert(semver_parse_arena(&arena, "2.0.0-rc.1", &ver2) == 0);
+  assert(strcmp(ver2.prerelease, "rc.1") == 0);
+
+  /* Larger than a chunk */
+  assert(semver_parse_arena(&arena, "3.0.0-a-very-long-prerelease-identifier", &ver3) == 0);
+  assert(strcmp(ver3.prerelease, "a-very-long-prerelease-identifier") == 0);
+  assert(strcmp(ver.prerelease, "beta.1") == 0);
+  assert(strcmp(ver2.prerelease, "rc.1") == 0);
+
+  assert(semver_parse_arena(&arena, "1.2.3-", &ver) == -1);
+
+  /* Memory is reused after a reset */
+  semver_arena_reset(&arena);
+  assert(semver_parse_arena(&arena, "4.0.0-alpha", &ver) == 0);
+  assert(ver.prerelease == first);
+  assert(strcmp(ver.prerelease, "alpha") == 0);
+
+  semver_arena_destroy(&arena);
+  assert(arena.head == NULL);
+
+  test_end();
+}
+
+void
+test_parse_view() {
+  test_start("parse_view");
+
+  /* Not NUL terminated: the view must stop at the given length */
+  char buf[] = "1.2.12-beta.1+exp.sha.5114f85 trailing";
+  semver_view_t ver;
+
+  int error = semver_parse_view(buf, 29, &ver);
+
+  assert(error == 0);
+  assert(ver.major == 1);
+  assert(ver.minor == 2);
+  assert(ver.patch == 12);
+  assert(ver.src == buf);
+  assert(ver.prerelease.len == 6);
+  assert(memcmp(ver.src + ver.prerelease.offset, "beta.1", 6) == 0);
+  assert(ver.metadata.len == 15);
+  assert(memcmp(ver.src + ver.metadata.offset, "exp.sha.5114f85", 15) == 0);
+
+  error = semver_parse_view("1.2", 3, &ver);
+  assert(error == 0);
+  assert(ver.major == 1);
+  assert(ver.minor == 2);
+  assert(ver.patch == 0);
+  assert(ver.prerelease.len == 0);
+  assert(ver.metadata.len == 0);
+
+  assert(semver_parse_view(buf, strlen(buf), &ver) == -1);
+  assert(semver_parse_view("1.", 2, &ver) == -1);
+  assert(semver_parse_view("1.2.3-", 6, &ver) == -1);
+  assert(semver_parse_view("1.2.3+", 6, &ver) == -1);
+  assert(semver_parse_view("1.2.3-be$ta", 11, &ver) == -1);
+  assert(semver_parse_view("1.2.3.4", 7, &ver) == -1);
+  assert(semver_parse_view("v1.2.3", 6, &ver) == -1);
+  assert(semver_parse_view("99999999999", 11, &ver) == -1);
+
+  test_end();
+}
+
+struct scan_result {
+  size_t valid;
+  size_t invalid;
+  size_t stop;
+  unsigned long hash;
+  size_t offsets[8];
+  size_t lens[8];
+  int valids[8];
+};
+
+static int
+scan_helper (const semver_view_t *ver, const char *token, size_t len, size_t offset, void *data) {
+  struct scan_result *res = (struct scan_result *) data;
+  size_t n = res->valid + res->invalid;
+
+  if (n < 8) {
+    res->offsets[n] = offset;
+    res->lens[n] = len;
+    res->valids[n] = ver != NULL;
+  }
+
+  res->hash = res->hash * 31 + offset;
+  if (ver) {
+    assert(ver->src == token);
+    res->hash = res->hash * 31 + len + ver->major + ver->minor * 3 + ver->patch * 5;
+    res->valid++;
+  } else {
+    res->invalid++;
+  }
+
+  return res->stop && res->valid + res->invalid == res->stop ? 42 : 0;
+}
+
+void
+test_scan() {
+  test_start("semver_scan");
+
+  const char *input = "1.2.3\nfoo\t2.0.0-rc.1+b \r\n  01.0.0\n3.4.5";
+  struct scan_result res;
+
+  memset(&res, 0, sizeof(res));
+  assert(semver_scan(input, strlen(input), scan_helper, &res) == 0);
+  assert(res.valid == 3);
+  assert(res.invalid == 2);
+  assert(res.offsets[0] == 0 && res.lens[0] == 5 && res.valids[0]);
+  assert(res.offsets[1] == 6 && res.lens[1] == 3 && !res.valids[1]);
+  assert(res.offsets[2] == 10 && res.lens[2] == 12 && res.valids[2]);
+  assert(res.offsets[3] == 27 && res.lens[3] == 6 && !res.valids[3]);
+  assert(res.offsets[4] == 34 && res.lens[4] == 5 && res.valids[4]);
+
+  /* Not NUL terminated: the last token ends at len */
+  memset(&res, 0, sizeof(res));
+  assert(semver_scan(input, 3, scan_helper, &res) == 0);
+  assert(res.valid == 1 && res.lens[0] == 3);
+
+  memset(&res, 0, sizeof(res));
+  assert(semver_scan(" \n\t", 3, scan_helper, &res) == 0);
+  assert(res.valid == 0 && res.invalid == 0);
+
+  /* Stopped by the callback */
+  memset(&res, 0, sizeof(res));
+  res.stop = 2;
+  assert(semver_scan(input, strlen(input), scan_helper, &res) == 42);
+  assert(res.valid + res.invalid == 2);
+
+  test_end();
+}
+
+void
+test_scan_split() {
+  test_start("semver_scan_split");
+
+  const char *input = "1.2.3 2.0.0\n3.0.0-rc.1 invalid\t4.5.6  5.0.0 10.20.30";
+  size_t len = strlen(input), bounds[5], parts, i;
+  struct scan_result whole, part;
+
+  memset(&whole, 0, sizeof(whole));
+  assert(semver_scan(input, len, scan_helper, &whole) == 0);
+
+  for (parts = 1; parts <= 4; parts++) {
+    semver_scan_split(input, len, parts, bounds);
+    assert(bounds[0] == 0 && bounds[parts] == len);
+
+    memset(&part, 0, sizeof(part));
+    for (i = 0; i < parts; i++) {
+      assert(bounds[i] <= bounds[i + 1]);
+      assert(bounds[i] == 0 || bounds[i] == len || input[bounds[i]] == ' '
+             || input[bounds[i]] == '\n' || input[bounds[i]] == '\t');
+      assert(semver_scan(input + bounds[i], bounds[i + 1] - bounds[i], scan_helper, &part) == 0);
+    }
+
+    assert(part.valid == whole.valid);
+    assert(part.invalid == whole.invalid);
+  }
+
+  /* Long tokens push later boundaries forward */
+  semver_scan_split("1.0.0-aaaaaaaaaaaaaaaaaaaa 1", 28, 4, bounds);
+  assert(bounds[1] == 26 && bounds[2] == 26 && bounds[3] == 26 && bounds[4] == 28);
+
+  test_end();
+}
+
+void
+test_scan_file() {
+  test_start("semver_scan_file");
+
+  struct scan_result file, mem;
+  size_t i, invalid = 1, len = 0, cap = 400000;
+  char *buf = (char *) malloc(cap);
+  FILE *f = tmpfile();
+  assert(buf != NULL && f != NULL);
+
+  /* Enough tokens to span several reads, with one larger than a read */
+  for (i = 0; len < cap - 1000; i++) {
+    if (i == 7000) {
+      memset(buf + len, '1', 70000);
+      len += 70000;
+      buf[len++] = '\n';
+    }
+    invalid += i % 10 == 3;
+    len += sprintf(buf + len, i % 10 == 3 ? "v%lu.0\t" : "%lu.%lu.%lu-rc.%lu\n",
+                   (unsigned long) i, (unsigned long) i % 7, (unsigned long) i % 13, (unsigned long) i);
+  }
+
+  assert(fwrite(buf, 1, len, f) == len);
+  rewind(f);
+
+  memset(&mem, 0, sizeof(mem));
+  memset(&file, 0, sizeof(file));
+  assert(semver_scan(buf, len, scan_helper, &mem) == 0);
+  assert(semver_scan_file(f, scan_helper, &file) == 0);
+  assert(mem.valid == i + 1 - invalid);
+  assert(mem.invalid == invalid);
+  assert(file.valid == mem.valid);
+  assert(file.invalid == mem.invalid);
+  assert(file.hash == mem.hash);
+
+  rewind(f);
+  memset(&file, 0, sizeof(file));
+  file.stop = 3;
+  assert(semver_scan_file(f, scan_helper, &file) == 42);
+  assert(file.valid + file.invalid == 3);
+  assert(file.offsets[2] == mem.offsets[2]);
+  fclose(f);
+
+  /* Overlong tokens keep their first 256 bytes wherever reads split them:
+     whole in a read, completed by the next one, or cut after 280 bytes */
+  size_t starts[3] = {0, 65436, 65436 + 65536 - 280};
+  f = tmpfile();
+  assert(f != NULL);
+  memset(buf, ' ', starts[2] + 400);
+  for (i = 0; i < 3; i++) memset(buf + starts[i], '1', i ? 400 : 300);
+  assert(fwrite(buf, 1, starts[2] + 400, f) == starts[2] + 400);
+  rewind(f);
+
+  memset(&file, 0, sizeof(file));
+  assert(semver_scan_file(f, scan_helper, &file) == 0);
+  assert(file.invalid == 3 && file.valid == 0);
+  for (i = 0; i < 3; i++) assert(file.offsets[i] == starts[i] && file.lens[i] == 256);
+
+  fclose(f);
+  free(buf);
+  test_end();
+}
+
 void
 test_compare() {
   test_start("semver_compare");
@@ -499,6 +829,599 @@ test_satisfies() {
   test_end();
 }
 
+void
+test_compare_ptr() {
+  test_start("semver_compare_ptr");
+
+  char *versions[] = {
+    "1.0.0", "0.9.8", "1.0.0-beta.11", "2.1.0", "1.0.0-alpha",
+    "1.0.0-beta.2", "2.0.0", "1.0.0-alpha.1", "1.2.3+build", "1.2.2",
+  };
+  char *sorted[] = {
+    "0.9.8", "1.0.0-alpha", "1.0.0-alpha.1", "1.0.0-beta.2", "1.0.0-beta.11",
+    "1.0.0", "1.2.2", "1.2.3+build", "2.0.0", "2.1.0",
+  };
+  char *ops[] = {"=", ">=", "<=", "<", ">", "^", "~"};
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  semver_t arr[10], key, *found;
+  size_t i, j, k;
+
+  for (i = 0; i < n; i++)
+    assert(semver_parse(versions[i], &arr[i]) == 0);
+
+  /* Pointer variants agree with the by-value API */
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++) {
+      semver_t *x = &arr[i], *y = &arr[j];
+      assert(semver_compare_ptr(x, y) == semver_compare(*x, *y));
+      assert(semver_compare_version_ptr(x, y) == semver_compare_version(*x, *y));
+      assert(semver_compare_prerelease_ptr(x, y) == semver_compare_prerelease(*x, *y));
+      assert(semver_gt_ptr(x, y) == semver_gt(*x, *y));
+      assert(semver_gte_ptr(x, y) == semver_gte(*x, *y));
+      assert(semver_lt_ptr(x, y) == semver_lt(*x, *y));
+      assert(semver_lte_ptr(x, y) == semver_lte(*x, *y));
+      assert(semver_eq_ptr(x, y) == semver_eq(*x, *y));
+      assert(semver_neq_ptr(x, y) == semver_neq(*x, *y));
+      assert(semver_satisfies_caret_ptr(x, y) == semver_satisfies_caret(*x, *y));
+      assert(semver_satisfies_patch_ptr(x, y) == semver_satisfies_patch(*x, *y));
+      for (k = 0; k < sizeof(ops) / sizeof(ops[0]); k++)
+        assert(semver_satisfies_ptr(x, y, ops[k]) == semver_satisfies(*x, *y, ops[k]));
+    }
+  }
+
+  /* qsort and bsearch comparators */
+  qsort(arr, n, sizeof(arr[0]), semver_compare_asc);
+  for (i = 0; i < n; i++) {
+    assert(semver_parse(sorted[i], &key) == 0);
+    assert(semver_eq_ptr(&arr[i], &key));
+    found = (semver_t *) bsearch(&key, arr, n, sizeof(arr[0]), semver_compare_asc);
+    assert(found == &arr[i]);
+    semver_free(&key);
+  }
+
+  assert(semver_parse("1.0.0-beta", &key) == 0);
+  assert(bsearch(&key, arr, n, sizeof(arr[0]), semver_compare_asc) == NULL);
+  semver_free(&key);
+
+  qsort(arr, n, sizeof(arr[0]), semver_compare_desc);
+  for (i = 0; i < n; i++) {
+    assert(semver_parse(sorted[n - 1 - i], &key) == 0);
+    assert(semver_eq_ptr(&arr[i], &key));
+    semver_free(&key);
+  }
+
+  for (i = 0; i < n; i++)
+    semver_free(&arr[i]);
+
+  test_end();
+}
+
+void
+test_op() {
+  test_start("semver_op");
+
+  struct { char *str; semver_op_t op; } valid[] = {
+    {"=", SEMVER_OP_EQ}, {">", SEMVER_OP_GT}, {">=", SEMVER_OP_GTE},
+    {"<", SEMVER_OP_LT}, {"<=", SEMVER_OP_LTE}, {"~", SEMVER_OP_TILDE},
+    {"~>", SEMVER_OP_TILDE}, {"^", SEMVER_OP_CARET},
+  };
+  char *invalid[] = {"", "==", "=>", ">>", "!=", ">= ", "^1", "x", "<>"};
+  char *versions[] = {
+    "0.0.1", "0.1.0", "0.1.5", "1.0.0-alpha", "1.0.0", "1.2.3", "1.2.9", "1.3.0", "2.0.0", "2.0.0-rc.1",
+  };
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  semver_t arr[10];
+  unsigned char bitmap[2];
+  semver_op_t op;
+  size_t i, j, k, count;
+
+  for (i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+    assert(semver_op_parse(valid[i].str, &op) == 0);
+    assert(op == valid[i].op);
+  }
+
+  for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    assert(semver_op_parse(invalid[i], &op) == -1);
+
+  for (i = 0; i < n; i++)
+    assert(semver_parse(versions[i], &arr[i]) == 0);
+
+  /* Same results as semver_satisfies */
+  for (k = 0; k < sizeof(valid) / sizeof(valid[0]); k++) {
+    for (j = 0; j < n; j++) {
+      for (i = 0, count = 0; i < n; i++) {
+        int expected = semver_satisfies(arr[i], arr[j], valid[k].str);
+        assert(semver_satisfies_op(&arr[i], &arr[j], valid[k].op) == expected);
+        count += expected;
+      }
+
+      memset(bitmap, 0xff, sizeof(bitmap));
+      assert(semver_satisfies_op_many(arr, n, &arr[j], valid[k].op, bitmap) == count);
+      for (i = 0; i < n; i++)
+        assert(((bitmap[i / 8] >> (i % 8)) & 1) == semver_satisfies_op(&arr[i], &arr[j], valid[k].op));
+      assert((bitmap[1] >> 2) == 0);
+    }
+  }
+
+  for (i = 0; i < n; i++)
+    semver_free(&arr[i]);
+
+  test_end();
+}
+
+static void
+view_helper (char *a, char *b, int expected) {
+  semver_view_t verX, verY;
+
+  assert(semver_parse_view(a, strlen(a), &verX) == 0);
+  assert(semver_parse_view(b, strlen(b), &verY) == 0);
+  assert(semver_view_compare(&verX, &verY) == expected);
+}
+
+void
+test_column() {
+  test_start("semver_column");
+
+  const char *prs[] = {
+    NULL, NULL, NULL, "0", "1", "alpha", "alpha.1", "alpha.2", "beta", "beta.11", "rc.1",
+    "alphabet", "alphabet.2", "x-y-z", "4294967296",
+  };
+  const char *exprs[] = {
+    "^1.2.3", "~1.2.0 || >=3.0.0-alpha.1", "<1.0.0-beta || 2.x", ">1.2.3-alphabet.1 <=1.3.0-rc.1",
+    "1.2.3-alpha.1 - 2.0.0", "<0.0.0-0", "*",
+  };
+  size_t n = 1003, nprs = sizeof(prs) / sizeof(prs[0]), i, j, count;
+  unsigned char expected[126], bitmap[126];
+  semver_column_t col;
+  semver_range_t range;
+  semver_t *vers, y;
+  int op;
+
+  vers = (semver_t *) calloc(n, sizeof(*vers));
+  for (i = 0; i < n; i++) {
+    vers[i].major = (int) (i * 7 % 4);
+    vers[i].minor = (int) (i * 13 % 5);
+    vers[i].patch = (int) (i * 17 % 6);
+    vers[i].prerelease = (char *) prs[i * 11 % nprs];
+  }
+  assert(semver_column_build(&col, vers, n) == 0);
+  assert(col.len == n);
+
+  for (j = 0; j < n; j += 7) {
+    for (op = SEMVER_OP_EQ; op <= SEMVER_OP_CARET; op++) {
+      y = vers[j];
+      count = semver_satisfies_op_many(vers, n, &y, (semver_op_t) op, expected);
+      assert(semver_satisfies_many(&col, &y, (semver_op_t) op, bitmap) == count);
+      assert(memcmp(bitmap, expected, sizeof(bitmap)) == 0);
+    }
+  }
+
+  for (j = 0; j < sizeof(exprs) / sizeof(exprs[0]); j++) {
+    assert(semver_range_compile(exprs[j], &range) == 0);
+    memset(expected, 0, sizeof(expected));
+    for (i = 0, count = 0; i < n; i++) {
+      if (semver_range_match(&range, &vers[i])) {
+        expected[i / 8] |= (unsigned char) (1 << (i % 8));
+        count++;
+      }
+    }
+    assert(semver_range_match_many(&col, &range, bitmap) == count);
+    assert(memcmp(bitmap, expected, sizeof(bitmap)) == 0);
+    semver_range_free(&range);
+  }
+
+  semver_column_free(&col);
+  free(vers);
+  test_end();
+}
+
+void
+test_view_compare() {
+  test_start("semver_view_compare");
+
+  /* from: http://semver.org/spec/v2.0.0.html#spec-item-11 */
+  struct test_case cases[] = {
+    {"1.0.0-alpha", "1.0.0-alpha.1", -1},
+    {"1.0.0-alpha.1", "1.0.0-alpha.beta", -1},
+    {"1.0.0-alpha.beta", "1.0.0-beta", -1},
+    {"1.0.0-beta", "1.0.0-beta.2", -1},
+    {"1.0.0-beta.2", "1.0.0-beta.11", -1},
+    {"1.0.0-beta.11", "1.0.0-rc.1", -1},
+    {"1.0.0-rc.1", "1.0.0", -1},
+    {"1.0.0", "1.0.0+build.5", 0},
+    {"1.5.1-beta.1.123456789012345678901", "1.5.1-beta.1.12345678901234567890", 1},
+    {"2.0.0", "1.9.9", 1},
+  };
+
+  size_t i;
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    view_helper(cases[i].x, cases[i].y, cases[i].expected);
+    view_helper(cases[i].y, cases[i].x, -cases[i].expected);
+  }
+
+  test_end();
+}
+
+void
+test_view_satisfies() {
+  test_start("semver_view_satisfies");
+
+  struct test_case_match cases[] = {
+    {"1.0.9", "1.0.0", ">=", 1},
+    {"1.1.5", "1.1.9", ">=", 0},
+    {"1.2", "2.2", "<=", 1},
+    {"1.0.0-rc.1", "1.0.0", "<", 1},
+    {"1.0.0-rc.1", "1.0.0", "=", 0},
+    {"1.0.0+1", "1.0.0+2", "=", 1},
+    {"1.3.2", "1.1.9", "^", 1},
+    {"0.1.2", "0.2.9", "^", 0},
+    {"1.1.9", "1.1.3", "~", 1},
+    {"1.2.2", "1.3.9", "~", 0},
+  };
+
+  size_t i;
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    struct test_case_match args = cases[i];
+    semver_view_t verX, verY;
+
+    assert(semver_parse_view(args.x, strlen(args.x), &verX) == 0);
+    assert(semver_parse_view(args.y, strlen(args.y), &verY) == 0);
+
+    assert(semver_view_satisfies(&verX, &verY, args.op) == args.expected);
+  }
+
+  test_end();
+}
+
+void
+test_prerelease_tokens() {
+  test_start("semver_prerelease_compare");
+
+  char * versions[] = {
+    "1.0.0-alpha", "1.0.0-alpha.1", "1.0.0-alpha.beta", "1.0.0-beta", "1.0.0-beta.2",
+    "1.0.0-beta.11", "1.0.0-rc.1", "1.0.0", "1.0.0-nightly.20241016.3", "1.0.0-nightly.20241016.12",
+    "1.0.0-nightly.20241017.1", "1.0.0-1.123456789012345678901", "1.0.0-1.123456789012345678902",
+    "1.0.0-1.1234567890", "1.0.0-0", "1.0.0-00a", "1.0.0-x-y-z.-",
+  };
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  semver_view_t views[17];
+  semver_prerelease_t tokens[17];
+  size_t i, j;
+
+  for (i = 0; i < n; i++)
+    assert(semver_parse_tokens(versions[i], strlen(versions[i]), &views[i], &tokens[i]) == 0);
+
+  assert(tokens[7].src == NULL && tokens[7].count == 0);
+  assert(tokens[8].count == 3);
+  assert(tokens[8].ids[0].numeric == 0 && tokens[8].ids[0].len == 7);
+  assert(tokens[8].ids[1].numeric == 1 && tokens[8].ids[1].value == 20241016);
+  assert(tokens[8].ids[2].numeric == 1 && tokens[8].ids[2].value == 3);
+
+  for (i = 0; i < n; i++)
+    for (j = 0; j < n; j++)
+      assert(semver_prerelease_compare(&tokens[i], &tokens[j])
+          == semver_view_compare_prerelease(&views[i], &views[j]));
+
+  semver_prerelease_t pr;
+  assert(semver_prerelease_tokenize("a.b.c.d.e.f.g.h.i.j.k.l.m.n.o.p", 31, &pr) == 0);
+  assert(pr.count == 16);
+  assert(semver_prerelease_tokenize("a.b.c.d.e.f.g.h.i.j.k.l.m.n.o.p.q", 33, &pr) == -1);
+
+  test_end();
+}
+
+void
+test_range() {
+  test_start("semver_range");
+
+  struct test_case cases[] = {
+    {"1.2.3", "1.2.3", 1},
+    {"=1.2.3", "1.2.3+build", 1},
+    {"v1.2.3", "1.2.4", 0},
+    {">1.2.3", "1.2.4-0", 1},
+    {">1.2.3", "1.2.3", 0},
+    {">= 1.2.3", "1.2.3", 1},
+    {"<1.2.3", "1.2.3-beta", 1},
+    {"<=1.2.3", "1.2.3", 1},
+    {"<=1.2.3", "1.2.4-0", 0},
+    {"*", "0.0.0-0", 1},
+    {"", "99.99.99", 1},
+    {"x", "1.0.0", 1},
+    {"1.x", "1.99.99", 1},
+    {"1.x", "2.0.0-0", 0},
+    {"1.x", "1.0.0-beta", 0},
+    {"1.2.*", "1.2.99", 1},
+    {"1.2.*", "1.3.0", 0},
+    {"1", "1.5.0", 1},
+    {"1.2", "1.3.0", 0},
+    {">1", "2.0.0", 1},
+    {">1", "1.99.0", 0},
+    {">1.2", "1.3.0", 1},
+    {">1.2", "1.2.99", 0},
+    {"<1.2", "1.2.0-0", 0},
+    {"<1.2", "1.1.99", 1},
+    {"<=1.2", "1.2.99", 1},
+    {"<=1.2", "1.3.0-0", 0},
+    {">*", "1.0.0", 0},
+    {"~1.2.3", "1.2.9", 1},
+    {"~1.2.3", "1.3.0", 0},
+    {"~1.2.3", "1.2.2", 0},
+    {"~1.2", "1.2.0", 1},
+    {"~1", "1.9.0", 1},
+    {"~>1.2.3", "1.2.5", 1},
+    {"~1.2.3-beta.2", "1.2.3-beta.4", 1},
+    {"~1.2.3-beta.2", "1.2.3-beta.1", 0},
+    {"^1.2.3", "1.9.9", 1},
+    {"^1.2.3", "2.0.0", 0},
+    {"^1.2.3", "2.0.0-0", 0},
+    {"^1.2.3", "1.2.2", 0},
+    {"^0.2.3", "0.2.9", 1},
+    {"^0.2.3", "0.3.0", 0},
+    {"^0.0.3", "0.0.3", 1},
+    {"^0.0.3", "0.0.4", 0},
+    {"^0.0", "0.0.9", 1},
+    {"^0.0", "0.1.0", 0},
+    {"^0.x", "0.9.0", 1},
+    {"^1.2.x", "1.3.0", 1},
+    {"^1.2.3-beta.2", "1.2.3-beta.3", 1},
+    {"^1.2.3-beta.2", "1.2.3-beta.1", 0},
+    {"1.2.3 - 2.3.4", "2.3.4", 1},
+    {"1.2.3 - 2.3.4", "2.3.5", 0},
+    {"1.2 - 2.3.4", "1.2.0", 1},
+    {"1.2.3 - 2.3", "2.3.99", 1},
+    {"1.2.3 - 2.3", "2.4.0-0", 0},
+    {"1.2.3 - 2", "2.99.0", 1},
+    {">=1.2.3 <1.3.0", "1.2.9", 1},
+    {">=1.2.3 <1.3.0", "1.3.0", 0},
+    {">1.2.3 <1.2.3", "1.2.3", 0},
+    {">1.2.3 <1.2.4-0", "1.2.4-0", 0},
+    {">=1.2.3-beta.0", "1.2.3-beta.0", 1},
+    {"<1.2.3-beta.0", "1.2.3-beta", 1},
+    {"^1.2.3 || >=2.0.0 <2.5.0 || 3.x || 1.0.0 - 1.4.0", "1.1.0", 1},
+    {"^1.2.3 || >=2.0.0 <2.5.0 || 3.x || 1.0.0 - 1.4.0", "2.4.9", 1},
+    {"^1.2.3 || >=2.0.0 <2.5.0 || 3.x || 1.0.0 - 1.4.0", "2.5.0", 0},
+    {"^1.2.3 || >=2.0.0 <2.5.0 || 3.x || 1.0.0 - 1.4.0", "3.7.1", 1},
+    {"^1.2.3 || >=2.0.0 <2.5.0 || 3.x || 1.0.0 - 1.4.0", "0.9.0", 0},
+    {"<1.0.0||>=2.0.0", "1.5.0", 0},
+    {"<1.0.0||>=2.0.0", "0.5.0", 1},
+    {"1.0.0-alpha.1 || 1.0.0-alpha.beta", "1.0.0-alpha.beta", 1},
+    {">=1.0.0-alpha.10", "1.0.0-alpha.9", 0},
+    {">=1.0.0-alpha.10", "1.0.0-alpha.11", 1},
+  };
+
+  size_t i;
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    semver_range_t range;
+    semver_t ver = {0};
+    semver_view_t view;
+
+    assert(semver_range_compile(cases[i].x, &range) == 0);
+    assert(semver_parse(cases[i].y, &ver) == 0);
+    assert(semver_parse_view(cases[i].y, strlen(cases[i].y), &view) == 0);
+
+    assert(semver_range_match(&range, &ver) == cases[i].expected);
+    assert(semver_range_match_view(&range, &view) == cases[i].expected);
+
+    semver_range_free(&range);
+    semver_free(&ver);
+  }
+
+  char * invalid[] = {
+    "foo", "1.2.3 -", ">=", "1.2.3 | 2", "1.2-beta", "01.2.3", ">=1.2.3.4", "1.2.3 - >2",
+  };
+  for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    semver_range_t range;
+    assert(semver_range_compile(invalid[i], &range) == -1);
+  }
+
+  /* Sets are normalized into sorted disjoint intervals */
+  semver_range_t range;
+  assert(semver_range_compile("3.x || ^1.2.3 || 1.0.0 - 1.4.0 || 2.0.0 - 2.1.0 || >2.1.0 <2.5.0", &range) == 0);
+  assert(range.len == 3);
+  assert(range.intervals[0].lo.key.w[0] == 1 && range.intervals[0].lo.key.w[1] == 0);
+  assert(range.intervals[0].hi.key.w[0] == 2 && range.intervals[0].hi.key.w[3] == 0);
+  assert(range.intervals[1].lo.key.w[0] == 2 && range.intervals[1].lo.key.w[1] == 0);
+  assert(range.intervals[1].hi.key.w[0] == 2 && range.intervals[1].hi.key.w[1] == 5);
+  assert(range.intervals[2].lo.key.w[0] == 3);
+  semver_range_free(&range);
+
+  assert(semver_range_compile(">2 <1", &range) == 0);
+  assert(range.len == 0);
+  semver_range_free(&range);
+
+  /* No version sorts between these bounds */
+  assert(semver_range_compile(">1.2.3 <1.2.4-0", &range) == 0);
+  assert(range.len == 0);
+  semver_range_free(&range);
+  assert(semver_range_compile(">1.2.3-beta <1.2.3-beta.0", &range) == 0);
+  assert(range.len == 0);
+  semver_range_free(&range);
+
+  /* Equivalent bounds are stored alike, so touching sets merge */
+  assert(semver_range_compile("<=1.2.3 || >=1.2.4-0", &range) == 0);
+  assert(range.len == 1);
+  semver_range_free(&range);
+  assert(semver_range_compile("<=1.2.3-beta || >=1.2.3-beta.0", &range) == 0);
+  assert(range.len == 1);
+  semver_range_free(&range);
+
+  test_end();
+}
+
+void
+test_range_algebra() {
+  test_start("semver_range_algebra");
+
+  const char *exprs[] = {
+    "^1.2.3", "~1.4.0 || >=3.0.0-beta.2", "<1.0.0 || 2.x", ">1.2.3 <=1.5.0-rc.1",
+    "1.2.3 - 2.0.0", ">=2.1.0-0 <2.1.0", "*", "<0.0.0-0", "1.4.2",
+  };
+  const char *vers[] = {
+    "0.0.0-0", "0.9.9", "1.0.0", "1.2.3-alpha", "1.2.3", "1.2.4", "1.4.0", "1.4.7",
+    "1.5.0-rc.1", "1.5.0-rc.2", "1.5.0", "1.99.0", "2.0.0-0", "2.0.0", "2.1.0-alpha",
+    "2.1.0", "3.0.0-beta.1", "3.0.0-beta.2", "3.0.0", "99.0.0",
+  };
+  size_t n = sizeof(exprs) / sizeof(exprs[0]), m = sizeof(vers) / sizeof(vers[0]);
+  semver_range_t ranges[9], inter, uni, comp;
+  semver_t v[20];
+  size_t i, j, k;
+  int ma, mb, some, all;
+
+  for (i = 0; i < n; i++) assert(semver_range_compile(exprs[i], &ranges[i]) == 0);
+  for (k = 0; k < m; k++) assert(semver_parse(vers[k], &v[k]) == 0);
+
+  /* Results agree with matching every version against the operands */
+  for (i = 0; i < n; i++) {
+    assert(semver_range_complement(&ranges[i], &comp) == 0);
+    for (k = 0; k < m; k++)
+      assert(semver_range_match(&comp, &v[k]) == !semver_range_match(&ranges[i], &v[k]));
+    semver_range_free(&comp);
+
+    for (j = 0; j < n; j++) {
+      assert(semver_range_intersect(&ranges[i], &ranges[j], &inter) == 0);
+      assert(semver_range_union(&ranges[i], &ranges[j], &uni) == 0);
+      some = 0;
+      all = 1;
+      for (k = 0; k < m; k++) {
+        ma = semver_range_match(&ranges[i], &v[k]);
+        mb = semver_range_match(&ranges[j], &v[k]);
+        assert(semver_range_match(&inter, &v[k]) == (ma && mb));
+        assert(semver_range_match(&uni, &v[k]) == (ma || mb));
+        some |= ma && mb;
+        all &= !ma || mb;
+      }
+      assert(semver_range_intersects(&ranges[i], &ranges[j]) == (inter.len > 0));
+      if (some) assert(semver_range_intersects(&ranges[i], &ranges[j]));
+      if (semver_range_subset(&ranges[i], &ranges[j])) assert(all);
+      semver_range_free(&inter);
+      semver_range_free(&uni);
+    }
+  }
+
+  assert(semver_range_subset(&ranges[3], &ranges[0]));
+  assert(semver_range_subset(&ranges[8], &ranges[1]));
+  assert(!semver_range_subset(&ranges[1], &ranges[0]));
+  assert(semver_range_subset(&ranges[7], &ranges[8]));
+  assert(semver_range_subset(&ranges[0], &ranges[6]));
+  assert(!semver_range_intersects(&ranges[0], &ranges[5]));
+
+  /* Ranges matching nothing are empty, whatever their bounds */
+  semver_range_t none, gt, gte;
+  assert(semver_range_compile(">1.2.3 <1.2.4-0", &none) == 0);
+  assert(!semver_range_intersects(&none, &none));
+  assert(semver_range_subset(&none, &ranges[7]));
+  assert(semver_range_subset(&none, &ranges[8]));
+  semver_range_free(&none);
+
+  /* Bounds written differently over the same versions */
+  assert(semver_range_compile(">1.2.3", &gt) == 0);
+  assert(semver_range_compile(">=1.2.4-0", &gte) == 0);
+  assert(semver_range_subset(&gt, &gte) && semver_range_subset(&gte, &gt));
+  semver_range_free(&gt);
+  semver_range_free(&gte);
+  assert(semver_range_compile(">1.2.3-beta", &gt) == 0);
+  assert(semver_range_compile(">=1.2.3-beta.0", &gte) == 0);
+  assert(semver_range_subset(&gt, &gte) && semver_range_subset(&gte, &gt));
+  semver_range_free(&gte);
+  assert(semver_range_compile("<=1.2.3-beta", &gte) == 0);
+  assert(semver_range_union(&gt, &gte, &uni) == 0);
+  assert(semver_range_subset(&ranges[6], &uni));
+  assert(semver_range_complement(&gte, &comp) == 0);
+  assert(semver_range_subset(&comp, &gt) && semver_range_subset(&gt, &comp));
+  semver_range_free(&gt);
+  semver_range_free(&gte);
+  semver_range_free(&uni);
+  semver_range_free(&comp);
+
+  /* Highest version allowed by several dependents */
+  semver_index_t index;
+  size_t pos;
+  assert(semver_index_build(&index, v, m) == 0);
+  assert(semver_range_intersect(&ranges[0], &ranges[1], &inter) == 0);
+  assert(semver_range_intersect(&inter, &ranges[4], &uni) == 0);
+  assert(semver_index_max_satisfying(&index, &uni, &pos) == 1);
+  assert(strcmp(vers[pos], "1.4.7") == 0);
+  semver_range_free(&inter);
+  semver_range_free(&uni);
+
+  /* Complementing twice gives back the same set */
+  assert(semver_range_complement(&ranges[1], &comp) == 0);
+  assert(semver_range_complement(&comp, &inter) == 0);
+  assert(semver_range_subset(&inter, &ranges[1]) && semver_range_subset(&ranges[1], &inter));
+  semver_range_free(&comp);
+  semver_range_free(&inter);
+
+  semver_index_free(&index);
+  for (i = 0; i < n; i++) semver_range_free(&ranges[i]);
+  for (k = 0; k < m; k++) semver_free(&v[k]);
+  test_end();
+}
+
+void
+test_index() {
+  test_start("semver_index");
+
+  char * versions[] = {
+    "1.0.0", "0.9.0", "1.2.3", "1.2.3-beta.2", "1.2.3-beta.10", "1.2.3-beta.1",
+    "1.2.4", "1.3.0", "2.0.0-rc.1", "2.0.0", "2.4.9", "2.5.0", "3.0.0-alpha",
+    "3.7.1", "1.2.3", "0.0.1", "4.0.0", "1.2.3-nightly.20241016.3", "1.2.3-nightly.20241016.12",
+  };
+  char * ranges[] = {
+    "^1.2.3", "~1.2.3", ">=2.0.0 <2.5.0", "3.x", "1.0.0 - 1.4.0", "*", ">4", "<0.0.1",
+    "^1.2.3 || >=2.0.0 <2.5.0 || 3.x || 1.0.0 - 1.4.0", ">=1.2.3-beta.2 <=1.2.3-nightly.20241016.3",
+    ">1.2.3-beta.2 <1.2.3-nightly.20241016.12", "1.2.3", "<1.2.3", "0.x || >=3.0.0-alpha",
+  };
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  semver_t vers[19];
+  semver_index_t index;
+  size_t i, j, pos;
+
+  for (i = 0; i < n; i++)
+    assert(semver_parse(versions[i], &vers[i]) == 0);
+
+  assert(semver_index_build(&index, vers, n) == 0);
+  assert(index.len == n);
+
+  for (i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+    semver_range_t range;
+    size_t count = 0;
+    semver_t *max = NULL, *min = NULL;
+
+    assert(semver_range_compile(ranges[i], &range) == 0);
+
+    /* Linear scan as reference */
+    for (j = 0; j < n; j++) {
+      if (!semver_range_match(&range, &vers[j])) continue;
+      count++;
+      if (max == NULL || semver_compare(vers[j], *max) > 0) max = &vers[j];
+      if (min == NULL || semver_compare(vers[j], *min) < 0) min = &vers[j];
+    }
+
+    assert(semver_index_count_satisfying(&index, &range) == count);
+    assert(semver_index_max_satisfying(&index, &range, &pos) == (max != NULL));
+    if (max) assert(semver_compare(vers[pos], *max) == 0);
+    assert(semver_index_min_satisfying(&index, &range, &pos) == (min != NULL));
+    if (min) assert(semver_compare(vers[pos], *min) == 0);
+
+    semver_range_free(&range);
+  }
+
+  semver_index_free(&index);
+
+  /* Empty index */
+  semver_range_t range;
+  assert(semver_range_compile("*", &range) == 0);
+  assert(semver_index_build(&index, vers, 0) == 0);
+  assert(semver_index_count_satisfying(&index, &range) == 0);
+  assert(semver_index_max_satisfying(&index, &range, &pos) == 0);
+  semver_index_free(&index);
+  semver_range_free(&range);
+
+  for (i = 0; i < n; i++) semver_free(&vers[i]);
+
+  test_end();
+}
+
 /**
  * Renders
  */
@@ -527,6 +1450,74 @@ test_render() {
   test_end();
 }
 
+void
+test_render_n() {
+  test_start("semver_render_n");
+
+  semver_t ver = {1, 5, 8, NULL, NULL};
+  char buf[32];
+
+  assert(semver_render_n(&ver, buf, sizeof(buf)) == 5);
+  assert(strcmp(buf, "1.5.8") == 0);
+
+  ver.prerelease = "alpha.1";
+  ver.metadata = "1232323";
+  assert(semver_render_n(&ver, buf, sizeof(buf)) == 21);
+  assert(strcmp(buf, "1.5.8-alpha.1+1232323") == 0);
+
+  /* Truncation */
+  assert(semver_render_n(&ver, buf, 21) == 21);
+  assert(strcmp(buf, "1.5.8-alpha.1+123232") == 0);
+  assert(semver_render_n(&ver, buf, 4) == 21);
+  assert(strcmp(buf, "1.5") == 0);
+  assert(semver_render_n(&ver, buf, 1) == 21);
+  assert(buf[0] == '\0');
+  buf[0] = 'x';
+  assert(semver_render_n(&ver, buf, 0) == 21);
+  assert(buf[0] == 'x');
+
+  semver_t big = {2147483647, 0, 10, NULL, "b"};
+  assert(semver_render_n(&big, buf, sizeof(buf)) == 17);
+  assert(strcmp(buf, "2147483647.0.10-b") == 0);
+
+  test_end();
+}
+
+void
+test_render_batch() {
+  test_start("semver_render_batch");
+
+  semver_t arr[] = {
+    {1, 0, 0, NULL, NULL},
+    {10, 20, 30, "rc.1", NULL},
+    {0, 0, 1, NULL, "build"},
+  };
+  char buf[64];
+  size_t offsets[4];
+
+  assert(semver_render_batch(arr, 3, buf, sizeof(buf), offsets) == 3);
+  assert(strcmp(buf + offsets[0], "1.0.0") == 0);
+  assert(strcmp(buf + offsets[1], "10.20.30+rc.1") == 0);
+  assert(strcmp(buf + offsets[2], "0.0.1-build") == 0);
+  assert(offsets[1] == 6);
+  assert(offsets[3] == 6 + 14 + 12);
+
+  /* Stops at the first version that does not fit */
+  assert(semver_render_batch(arr, 3, buf, 19, offsets) == 1);
+  assert(strcmp(buf + offsets[0], "1.0.0") == 0);
+  assert(offsets[1] == 6);
+  assert(buf[6] == '\0');
+
+  /* Exact fit */
+  assert(semver_render_batch(arr, 3, buf, 20, offsets) == 2);
+  assert(offsets[2] == 20);
+
+  assert(semver_render_batch(arr, 3, buf, 0, offsets) == 0);
+  assert(offsets[0] == 0);
+
+  test_end();
+}
+
 void
 test_numeric() {
   test_start("numeric");
@@ -561,10 +1552,774 @@ test_numeric() {
   test_end();
 }
 
+void
+test_key() {
+  test_start("key");
+
+  char * versions[] = {
+    "0.0.0", "0.0.1", "1.0.0-0", "1.0.0-1", "1.0.0-1.a", "1.0.0-1.b", "1.0.0-2",
+    "1.0.0-11", "1.0.0-1073741823", "1.0.0-1073741824", "1.0.0-99999999999",
+    "1.0.0-a", "1.0.0-alph", "1.0.0-alph.1", "1.0.0-alpha", "1.0.0-alpha.1",
+    "1.0.0-alpha.beta", "1.0.0-beta", "1.0.0-beta.2", "1.0.0-beta.11", "1.0.0-rc.1",
+    "1.0.0-0a", "1.0.0-A", "1.0.0-x-y-z.-", "1.0.0", "1.0.0+build.1",
+    "1.2.3", "2017.10.200", "2017.10.200-nightly.20241016.3", "2147483647.0.0",
+  };
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  semver_t vers[30];
+  semver_key_t keys[30];
+  int exact[30];
+  size_t i, j;
+
+  for (i = 0; i < n; i++) {
+    assert(semver_parse(versions[i], &vers[i]) == 0);
+    exact[i] = semver_key(&vers[i], &keys[i]);
+  }
+
+  assert(exact[0] == 1);
+  assert(exact[4] == 0);
+  assert(exact[12] == 1);
+  assert(exact[14] == 0);
+  assert(keys[27].w[0] == 2017 && keys[27].w[1] == 10 && keys[27].w[2] == 200);
+
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++) {
+      int expected = semver_compare(vers[i], vers[j]);
+      int res = semver_key_compare(&keys[i], &keys[j]);
+      if (res != 0 || (exact[i] && exact[j])) {
+        assert(res == expected);
+      }
+    }
+  }
+
+  for (i = 0; i < n; i++) {
+    semver_view_t view;
+    semver_key_t key;
+    assert(semver_parse_view(versions[i], strlen(versions[i]), &view) == 0);
+    assert(semver_view_key(&view, &key) == exact[i]);
+    assert(semver_key_compare(&key, &keys[i]) == 0);
+    semver_free(&vers[i]);
+  }
+
+  /* Bytes above 0x7f, which only hand-built versions can hold */
+  const char *high[] = {"\x80", "\x7fz", "\x7f\x7f\x7f\x7f", "\x7f\x7f\x7f\x7fz", "\x81", "a\x80", "a.b", "a\xff.1", "z"};
+  size_t nhigh = sizeof(high) / sizeof(high[0]);
+  semver_key_t hkeys[9];
+  int hexact[9];
+  semver_t hvers[9];
+  for (i = 0; i < nhigh; i++) {
+    hvers[i].major = hvers[i].minor = hvers[i].patch = 1;
+    hvers[i].prerelease = (char *) high[i];
+    hvers[i].metadata = NULL;
+    hexact[i] = semver_key(&hvers[i], &hkeys[i]);
+  }
+  assert(hexact[0] == 0 && hexact[2] == 1);
+  for (i = 0; i < nhigh; i++) {
+    for (j = 0; j < nhigh; j++) {
+      int res = semver_key_compare(&hkeys[i], &hkeys[j]);
+      if (res != 0 || (hexact[i] && hexact[j])) assert(res == semver_compare(hvers[i], hvers[j]));
+    }
+  }
+
+  /* Negative components cannot be ordered by keys */
+  semver_t neg[2] = {{1, 0, 0, NULL, NULL}, {0, -1, 0, NULL, NULL}};
+  semver_range_t range;
+  semver_index_t index;
+  semver_column_t col;
+  semver_key_t key;
+  assert(semver_key(&neg[1], &key) == -1);
+  assert(semver_sort(neg, 2) == -1);
+  assert(neg[0].major == 1 && neg[1].minor == -1);
+  assert(semver_index_build(&index, neg, 2) == -1);
+  assert(semver_column_build(&col, neg, 2) == -1);
+  assert(semver_range_compile("*", &range) == 0);
+  assert(semver_range_match(&range, &neg[1]) == 0);
+  semver_range_free(&range);
+
+  test_end();
+}
+
+void
+test_sort() {
+  test_start("sort");
+
+  char * versions[] = {
+    "1.0.0-rc.1", "1.0.0", "0.0.1", "1.0.0-beta.11", "1.0.0-alpha.beta", "2.0.0",
+    "1.0.0-beta.2", "1.0.0-alpha", "1.0.0-beta", "1.0.0-alpha.1", "0.0.0", "1.0.0-2",
+    "1.0.0-1.b", "1.0.0-1.a", "10.0.0", "1.10.0", "1.2.0", "1.0.0-nightly.20241016.3",
+    "1.0.0-nightly.20241016.12", "1.0.0-nightly.20241015.40", "256.0.0", "1.256.1",
+  };
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  semver_t vers[22];
+  semver_key_t keys[22];
+  size_t perm[22];
+  size_t i, j;
+
+  for (i = 0; i < n; i++) {
+    assert(semver_parse(versions[i], &vers[i]) == 0);
+    semver_key(&vers[i], &keys[i]);
+  }
+
+  assert(semver_sort(vers, n) == 0);
+  for (i = 1; i < n; i++)
+    assert(semver_compare(vers[i - 1], vers[i]) < 0);
+  assert(vers[0].major == 0 && vers[0].patch == 0);
+  assert(strcmp(vers[2].prerelease, "1.a") == 0);
+  assert(vers[n - 1].major == 256);
+
+  assert(semver_key_sort(keys, perm, n) == 0);
+  for (i = 1; i < n; i++)
+    assert(semver_key_compare(&keys[i - 1], &keys[i]) <= 0);
+
+  /* perm maps back to the original positions */
+  for (i = 0; i < n; i++) {
+    semver_t ver = {0};
+    semver_key_t key;
+    assert(semver_parse(versions[perm[i]], &ver) == 0);
+    semver_key(&ver, &key);
+    assert(semver_key_compare(&key, &keys[i]) == 0);
+    for (j = 0; j < i; j++) assert(perm[j] != perm[i]);
+    semver_free(&ver);
+  }
+
+  for (i = 0; i < n; i++) semver_free(&vers[i]);
+
+  assert(semver_sort(vers, 0) == 0);
+  assert(semver_key_sort(keys, NULL, 1) == 0);
+
+  test_end();
+}
+
+void
+test_merge() {
+  test_start("semver_merge");
+
+  char *versions[] = {
+    "1.0.0", "0.9.8", "1.0.0-beta.11", "2.1.0", "1.0.0-alpha", "1.0.0+b1",
+    "1.0.0-beta.2", "2.0.0", "1.0.0-alpha.1", "1.2.3+build", "1.2.2",
+    "0.0.1", "1.0.0+b2", "3.0.0-rc.1", "1.0.0-alpha", "10.0.0", "1.0.0+b3",
+  };
+  size_t n = sizeof(versions) / sizeof(versions[0]);
+  size_t bounds[] = {0, 5, 5, 11, 17};
+  size_t runs = sizeof(bounds) / sizeof(bounds[0]) - 1;
+  semver_t arr[17], all[17];
+  char *blocks[4], *block;
+  size_t out[17], i, r;
+
+  /* Parse and sort every chunk independently */
+  for (r = 0; r < runs; r++) {
+    assert(semver_parse_batch((const char **) versions + bounds[r], bounds[r + 1] - bounds[r],
+                              arr + bounds[r], NULL, &blocks[r]) == 0);
+    assert(semver_sort(arr + bounds[r], bounds[r + 1] - bounds[r]) == 0);
+  }
+
+  assert(semver_merge(arr, bounds, runs, out) == 0);
+
+  assert(semver_parse_batch((const char **) versions, n, all, NULL, &block) == 0);
+  assert(semver_sort(all, n) == 0);
+
+  for (i = 0; i < n; i++) {
+    assert(semver_eq_ptr(&arr[out[i]], &all[i]));
+    if (i > 0) {
+      assert(semver_lte_ptr(&arr[out[i - 1]], &arr[out[i]]));
+      /* Equal versions keep their run order */
+      if (semver_eq_ptr(&arr[out[i - 1]], &arr[out[i]])) assert(out[i - 1] < out[i]);
+    }
+  }
+
+  /* Every position appears once */
+  for (i = 0; i < n; i++) all[i].major = 0;
+  for (i = 0; i < n; i++) all[out[i]].major++;
+  for (i = 0; i < n; i++) assert(all[i].major == 1);
+
+  for (r = 0; r < runs; r++) free(blocks[r]);
+  free(block);
+
+  assert(semver_merge(arr, bounds, 0, out) == 0);
+
+  test_end();
+}
+
+#ifdef SEMVER_THREADS
+static int
+same_string (const char *x, const char *y) {
+  return x == y || (x && y && strcmp(x, y) == 0);
+}
+
+void
+test_parse_sort_parallel() {
+  test_start("semver_parse_sort_parallel");
+
+  size_t n = 20000, threads[] = {2, 3, 8, 64, 0};
+  const char **strs;
+  char *pool, *block, *other_block, *seen;
+  semver_t *out, *other;
+  size_t i, t, count, other_count, invalid;
+
+  strs = (const char **) malloc(n * sizeof(*strs));
+  pool = (char *) malloc(n * 32);
+  out = (semver_t *) malloc(n * sizeof(*out));
+  other = (semver_t *) malloc(n * sizeof(*other));
+
+  /* Many equal versions differing by metadata only, a few invalid ones */
+  for (i = 0, invalid = 0; i < n; i++) {
+    char *s = pool + i * 32;
+    if (i % 97 == 0) {
+      sprintf(s, "v1.%lu", (unsigned long) i);
+      invalid++;
+    } else if (i % 3 == 0) {
+      sprintf(s, "%lu.%lu.0-rc.%lu+b%lu", (unsigned long) (i % 7), (unsigned long) (i % 11),
+              (unsigned long) (i % 5), (unsigned long) i);
+    } else {
+      sprintf(s, "%lu.%lu.%lu+b%lu", (unsigned long) (i % 7), (unsigned long) (i % 11),
+              (unsigned long) (i % 4), (unsigned long) i);
+    }
+    strs[i] = s;
+  }
+
+  assert(semver_parse_sort_parallel(strs, n, 1, out, &count, &block) == 0);
+  assert(count == n - invalid);
+  for (i = 1; i < count; i++) assert(semver_compare(out[i - 1], out[i]) <= 0);
+
+  /* Every valid string appears once, told apart by its metadata */
+  seen = (char *) calloc(n, 1);
+  for (i = 0; i < count; i++) {
+    t = (size_t) atol(out[i].metadata + 1);
+    assert(t < n && t % 97 != 0 && !seen[t]);
+    seen[t] = 1;
+  }
+  free(seen);
+
+  /* Same result, equal versions included, for any number of threads */
+  for (t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+    assert(semver_parse_sort_parallel(strs, n, threads[t], other, &other_count, &other_block) == 0);
+    assert(other_count == count);
+    for (i = 0; i < count; i++) {
+      assert(semver_compare(out[i], other[i]) == 0);
+      assert(same_string(out[i].prerelease, other[i].prerelease));
+      assert(same_string(out[i].metadata, other[i].metadata));
+    }
+    free(other_block);
+  }
+  free(block);
+
+  assert(semver_parse_sort_parallel(strs, 0, 4, out, &count, &block) == 0);
+  assert(count == 0 && block == NULL);
+  assert(semver_parse_sort_parallel(strs, 1, 4, out, &count, &block) == 0);
+  assert(count == 0 && block == NULL);
+
+  free(strs);
+  free(pool);
+  free(out);
+  free(other);
+
+  test_end();
+}
+#endif
+
+void
+test_bitmap() {
+  test_start("semver_bitmap");
+
+  const char *exprs[] = {
+    "^1.0.0", "~2.5.0", ">=1.150.0 <3.0.0-0", "0.0.0 - 0.0.50 || 3.199.x", "<0.0.0-0",
+  };
+  size_t n = 140000, nexprs = sizeof(exprs) / sizeof(exprs[0]);
+  semver_bitmap_t bitmaps[5], out;
+  semver_range_t ranges[5];
+  semver_index_t index;
+  semver_t *vers;
+  size_t *values, i, j, k, p, x, count;
+  int ma, mb;
+
+  vers = (semver_t *) calloc(n, sizeof(*vers));
+  values = (size_t *) malloc(n * sizeof(*values));
+  for (p = 0; p < n; p++) {
+    x = p * 7919 % n;
+    vers[p].major = (int) (x / 40000);
+    vers[p].minor = (int) (x / 200 % 200);
+    vers[p].patch = (int) (x % 200);
+  }
+  assert(semver_index_build(&index, vers, n) == 0);
+
+  for (i = 0; i < nexprs; i++) {
+    assert(semver_range_compile(exprs[i], &ranges[i]) == 0);
+    assert(semver_index_bitmap(&index, &ranges[i], &bitmaps[i]) == 0);
+    assert(semver_bitmap_cardinality(&bitmaps[i]) == semver_index_count_satisfying(&index, &ranges[i]));
+
+    count = semver_bitmap_values(&bitmaps[i], values);
+    for (k = 0, p = 0; p < n; p++) {
+      ma = semver_range_match(&ranges[i], &vers[p]);
+      assert(semver_bitmap_contains(&bitmaps[i], p) == ma);
+      if (ma) assert(values[k++] == p);
+    }
+    assert(k == count);
+  }
+  assert(semver_bitmap_cardinality(&bitmaps[0]) == 40000);
+  assert(semver_bitmap_cardinality(&bitmaps[4]) == 0);
+  assert(!semver_bitmap_contains(&bitmaps[0], n + 100000));
+
+  for (i = 0; i < nexprs; i++) {
+    for (j = 0; j < nexprs; j++) {
+      assert(semver_bitmap_and(&bitmaps[i], &bitmaps[j], &out) == 0);
+      for (p = 0, count = 0; p < n; p += 3) {
+        ma = semver_bitmap_contains(&bitmaps[i], p);
+        mb = semver_bitmap_contains(&bitmaps[j], p);
+        assert(semver_bitmap_contains(&out, p) == (ma && mb));
+      }
+      semver_bitmap_free(&out);
+
+      assert(semver_bitmap_or(&bitmaps[i], &bitmaps[j], &out) == 0);
+      for (p = 1; p < n; p += 3) {
+        ma = semver_bitmap_contains(&bitmaps[i], p);
+        mb = semver_bitmap_contains(&bitmaps[j], p);
+        assert(semver_bitmap_contains(&out, p) == (ma || mb));
+      }
+      semver_bitmap_free(&out);
+
+      assert(semver_bitmap_andnot(&bitmaps[i], &bitmaps[j], &out) == 0);
+      for (p = 2; p < n; p += 3) {
+        ma = semver_bitmap_contains(&bitmaps[i], p);
+        mb = semver_bitmap_contains(&bitmaps[j], p);
+        assert(semver_bitmap_contains(&out, p) == (ma && !mb));
+      }
+      if (i == j) assert(semver_bitmap_cardinality(&out) == 0);
+      semver_bitmap_free(&out);
+    }
+  }
+
+  /* ^1.0.0 and >=1.150.0 <3.0.0-0 share 1.150.0 - 1.199.199 */
+  assert(semver_bitmap_and(&bitmaps[0], &bitmaps[2], &out) == 0);
+  assert(semver_bitmap_cardinality(&out) == 50 * 200);
+  semver_bitmap_free(&out);
+
+  for (i = 0; i < nexprs; i++) {
+    semver_bitmap_free(&bitmaps[i]);
+    semver_range_free(&ranges[i]);
+  }
+  semver_index_free(&index);
+  free(values);
+  free(vers);
+  test_end();
+}
+
+void
+test_pack() {
+  test_start("semver_pack");
+
+  const char *tags[] = {"alpha.1", "alpha.2", "beta", "beta.11", "rc.1"};
+  semver_t vers[300], ver, *all;
+  semver_pack_t pack;
+  unsigned char *buf;
+  char str[64], *block;
+  size_t n, size, text, i;
+
+  /* A sorted list with prereleases, metadata and big jumps */
+  for (n = 0, text = 0; n < 300; n++) {
+    if (n % 7 == 3) {
+      sprintf(str, "%lu.%lu.%lu-%s", (unsigned long) (n / 50), (unsigned long) (n / 10 % 5),
+              (unsigned long) (n % 10), tags[n % 5]);
+    } else if (n % 31 == 0) {
+      sprintf(str, "%lu.%lu.%lu+build.%lu", (unsigned long) (n / 50), (unsigned long) (n / 10 % 5),
+              (unsigned long) (n % 10), (unsigned long) n);
+    } else {
+      sprintf(str, "%lu.%lu.%lu", (unsigned long) (n / 50), (unsigned long) (n / 10 % 5),
+              (unsigned long) (n % 10));
+    }
+    if (n == 299) strcpy(str, "2147483647.0.1-x");
+    text += strlen(str) + 1;
+    assert(semver_parse(str, &vers[n]) == 0);
+  }
+  semver_sort(vers, n);
+
+  size = semver_pack(vers, n, NULL, 0);
+  assert(size > 0 && size < text * 2 / 3);
+  buf = (unsigned char *) malloc(size + 1);
+  buf[size] = 0xaa;
+  assert(semver_pack(vers, n, buf, 10) == size);
+  assert(semver_pack(vers, n, buf, size) == size);
+  assert(buf[size] == 0xaa);
+
+  assert(semver_pack_open(&pack, buf, size) == 0);
+  assert(pack.count == n);
+
+  for (i = 0; i < n; i++) {
+    assert(semver_unpack(&pack, i, &ver) == 0);
+    assert(semver_compare_ptr(&ver, &vers[i]) == 0);
+    assert((ver.metadata == NULL) == (vers[i].metadata == NULL));
+    if (ver.metadata) assert(strcmp(ver.metadata, vers[i].metadata) == 0);
+    semver_free(&ver);
+  }
+  assert(semver_unpack(&pack, n, &ver) == -1);
+
+  all = (semver_t *) malloc(n * sizeof(*all));
+  assert(semver_unpack_all(&pack, all, &block) == 0);
+  for (i = 0; i < n; i++) {
+    assert(semver_compare_ptr(&all[i], &vers[i]) == 0);
+    assert((all[i].prerelease == NULL) == (vers[i].prerelease == NULL));
+  }
+  free(block);
+
+  /* Truncated or corrupted input is rejected, never read past its end */
+  assert(semver_pack_open(&pack, buf, 11) == -1);
+  assert(semver_pack_open(&pack, buf, 20) == -1);
+  assert(semver_pack_open(&pack, buf, size - 1) == 0);
+  assert(semver_unpack(&pack, n - 1, &ver) == -1);
+  for (i = 12; i < size; i += 3) {
+    buf[i] ^= 0x5a;
+    if (semver_pack_open(&pack, buf, size) == 0 && semver_unpack_all(&pack, all, &block) == 0)
+      free(block);
+    buf[i] ^= 0x5a;
+  }
+
+  assert(semver_pack(vers, 0, buf, size) == 12);
+  assert(semver_pack_open(&pack, buf, 12) == 0 && pack.count == 0);
+
+  for (i = 0; i < n; i++) semver_free(&vers[i]);
+  free(all);
+  free(buf);
+  test_end();
+}
+
+void
+test_hash() {
+  test_start("semver_hash");
+
+  char *equal[][2] = {
+    {"1.2.3", "1.2.3+build.1"},
+    {"1.2.3-alpha.1", "1.2.3-alpha.1+exp.sha.5114f85"},
+    {"0.0.0-rc", "0.0.0-rc"},
+  };
+  char *distinct[] = {
+    "1.2.3", "1.2.4", "1.3.3", "2.2.3", "1.2.3-0", "1.2.3-alpha",
+    "1.2.3-alpha.1", "1.2.3-alpha.1.0", "1.2.3-alpha1", "3.2.1",
+  };
+  semver_t x, y;
+  semver_view_t view;
+  unsigned long hashes[10];
+  size_t i, j, hits;
+
+  for (i = 0; i < sizeof(equal) / sizeof(equal[0]); i++) {
+    assert(semver_parse(equal[i][0], &x) == 0);
+    assert(semver_parse(equal[i][1], &y) == 0);
+    assert(semver_eq(x, y));
+    assert(semver_hash(&x) == semver_hash(&y));
+    assert(semver_parse_view(equal[i][1], strlen(equal[i][1]), &view) == 0);
+    assert(semver_view_hash(&view) == semver_hash(&x));
+    semver_free(&x);
+    semver_free(&y);
+  }
+
+  /* Numeric identifiers compare, so hash, by value */
+  semver_t a = {1, 0, 0, NULL, "beta.01"};
+  semver_t b = {1, 0, 0, NULL, "beta.1"};
+  semver_t c = {1, 0, 0, NULL, "beta.01a"};
+  semver_t d = {1, 0, 0, NULL, "beta.1a"};
+  assert(semver_eq(a, b) && semver_hash(&a) == semver_hash(&b));
+  assert(!semver_eq(c, d) && semver_hash(&c) != semver_hash(&d));
+
+  for (i = 0; i < 10; i++) {
+    assert(semver_parse(distinct[i], &x) == 0);
+    hashes[i] = semver_hash(&x);
+    semver_free(&x);
+  }
+
+  for (i = 0, hits = 0; i < 10; i++)
+    for (j = i + 1; j < 10; j++)
+      hits += hashes[i] == hashes[j];
+  assert(hits == 0);
+
+  test_end();
+}
+
+void
+test_set() {
+  test_start("semver_set");
+
+  semver_set_t set;
+  semver_t x, ver;
+  char buf[32];
+  size_t i, pos, count;
+
+  semver_set_init(&set);
+
+  semver_t rel = {1, 0, 0, NULL, NULL};
+  semver_t pre = {1, 0, 0, NULL, "rc.1"};
+  semver_t meta = {1, 0, 0, "build", NULL};
+  semver_t pre_meta = {1, 0, 0, "other", "rc.1"};
+  semver_t empty = {1, 0, 0, NULL, ""};
+
+  assert(!semver_set_contains(&set, &rel));
+  assert(semver_set_insert(&set, &rel) == 1);
+  assert(semver_set_insert(&set, &pre) == 1);
+  assert(semver_set_insert(&set, &meta) == 0);
+  assert(semver_set_insert(&set, &pre_meta) == 0);
+  assert(semver_set_insert(&set, &empty) == 1);
+  assert(set.len == 3);
+  assert(semver_set_contains(&set, &rel));
+  assert(semver_set_contains(&set, &meta));
+  assert(semver_set_contains(&set, &pre_meta));
+
+  /* Grow past the initial capacity */
+  for (i = 0; i < 1000; i++) {
+    sprintf(buf, "%lu.%lu.%lu-pre.%lu", (unsigned long) i % 10, (unsigned long) i / 10,
+            (unsigned long) i % 3, (unsigned long) i % 7);
+    assert(semver_parse(buf, &x) == 0);
+    assert(semver_set_insert(&set, &x) == 1);
+    assert(semver_set_insert(&set, &x) == 0);
+    semver_free(&x);
+  }
+  assert(set.len == 1003);
+
+  for (i = 0; i < 1000; i += 37) {
+    sprintf(buf, "%lu.%lu.%lu-pre.%lu", (unsigned long) i % 10, (unsigned long) i / 10,
+            (unsigned long) i % 3, (unsigned long) i % 7);
+    assert(semver_parse(buf, &x) == 0);
+    assert(semver_set_contains(&set, &x));
+    x.patch++;
+    assert(!semver_set_contains(&set, &x));
+    semver_free(&x);
+  }
+
+  /* Every version is visited once */
+  for (pos = 0, count = 0; semver_set_next(&set, &pos, &ver); count++) {
+    assert(ver.metadata == NULL);
+    assert(semver_set_contains(&set, &ver));
+  }
+  assert(count == set.len);
+
+  semver_set_free(&set);
+  assert(!semver_set_contains(&set, &rel));
+
+  test_end();
+}
+
+void
+test_counter() {
+  test_start("semver_counter");
+
+  semver_counter_t counter;
+  semver_t ver;
+  unsigned long count, total;
+  size_t pos;
+
+  semver_t a = {2, 1, 0, NULL, NULL};
+  semver_t a_meta = {2, 1, 0, "sha.1", NULL};
+  semver_t b = {2, 1, 0, NULL, "beta"};
+  semver_t c = {0, 0, 1, NULL, NULL};
+
+  semver_counter_init(&counter);
+  assert(semver_counter_get(&counter, &a) == 0);
+  assert(semver_counter_add(&counter, &a, 1) == 0);
+  assert(semver_counter_add(&counter, &a_meta, 2) == 0);
+  assert(semver_counter_add(&counter, &b, 5) == 0);
+  assert(semver_counter_add(&counter, &c, 0) == 0);
+
+  assert(semver_counter_get(&counter, &a) == 3);
+  assert(semver_counter_get(&counter, &b) == 5);
+  assert(semver_counter_get(&counter, &c) == 0);
+
+  for (pos = 0, total = 0; semver_counter_next(&counter, &pos, &ver, &count); )
+    total += count;
+  assert(total == 8);
+
+  semver_counter_free(&counter);
+  test_end();
+}
+
 /**
  * Modifiers
  */
 
+void
+test_cache() {
+  test_start("semver_cache");
+
+  semver_cache_t cache;
+  const semver_t *ver, *first;
+  semver_t expected;
+  char str[32], junk[4096];
+  size_t i, round;
+
+  semver_cache_init(&cache, 2);
+  assert(semver_parse_cached(&cache, "1.2.3-beta+b1", &ver) == 0);
+  assert(ver->major == 1 && ver->minor == 2 && ver->patch == 3);
+  assert(strcmp(ver->prerelease, "beta") == 0);
+  assert(strcmp(ver->metadata, "b1") == 0);
+  first = ver;
+
+  assert(semver_parse_cached(&cache, "1.2.3-beta+b1", &ver) == 0);
+  assert(ver == first);
+  assert(semver_parse_cached(&cache, "v1.2.3", &ver) == -1);
+  assert(ver == NULL);
+  assert(semver_parse_cached(&cache, "v1.2.3", &ver) == -1);
+  assert(cache.hits == 2 && cache.misses == 2 && cache.evictions == 0);
+
+  /* Both entries were hit: the hand clears them and evicts the oldest */
+  assert(semver_parse_cached(&cache, "2.0.0", &ver) == 0);
+  assert(ver->major == 2 && ver->prerelease == NULL && ver->metadata == NULL);
+  assert(cache.evictions == 1);
+  assert(semver_parse_cached(&cache, "v1.2.3", &ver) == -1);
+  assert(cache.hits == 3);
+  assert(semver_parse_cached(&cache, "1.2.3-beta+b1", &ver) == 0);
+  assert(cache.misses == 4 && cache.evictions == 2);
+  semver_cache_free(&cache);
+
+  /* Hot cache: the result of the previous call survives the next miss */
+  semver_cache_init(&cache, 2);
+  for (i = 0; i < 6; i++) {
+    assert(semver_parse_cached(&cache, "9.9.9", &ver) == 0);
+    assert(semver_parse_cached(&cache, "9.9.9", &ver) == 0);
+    sprintf(str, "%lu.0.0-x", (unsigned long) i);
+    assert(semver_parse_cached(&cache, str, &first) == 0);
+    sprintf(str, "%lu.0.0-y", (unsigned long) i + 1);
+    assert(semver_parse_cached(&cache, str, &ver) == 0);
+    assert(semver_compare_ptr(first, ver) < 0);
+    assert(strcmp(first->prerelease, "x") == 0);
+  }
+  semver_cache_free(&cache);
+
+  /* Overlong input is rejected without taking a slot */
+  semver_cache_init(&cache, 2);
+  memset(junk, '1', sizeof(junk) - 1);
+  junk[sizeof(junk) - 1] = '\0';
+  assert(semver_parse_cached(&cache, junk, &ver) == -1 && ver == NULL);
+  assert(semver_parse_cached(&cache, junk, &ver) == -1);
+  assert(cache.len == 0 && cache.misses == 2 && cache.hits == 0);
+  junk[255] = '\0';
+  assert(semver_parse_cached(&cache, junk, &ver) == -1);
+  assert(cache.len == 1);
+  semver_cache_free(&cache);
+
+  /* A capacity of one is raised to two */
+  semver_cache_init(&cache, 1);
+  assert(cache.cap == 2);
+  assert(semver_parse_cached(&cache, "1.0.0", &first) == 0);
+  assert(semver_parse_cached(&cache, "2.0.0", &ver) == 0);
+  assert(semver_parse_cached(&cache, "3.0.0", &ver) == 0);
+  assert(semver_parse_cached(&cache, "2.0.0", &first) == 0 && cache.hits == 1);
+  assert(semver_parse_cached(&cache, "4.0.0", &ver) == 0);
+  assert(first->major == 2 && ver->major == 4);
+  semver_cache_free(&cache);
+
+  /* More versions than slots, mixing hits, misses and evictions */
+  semver_cache_init(&cache, 8);
+  for (round = 0; round < 3; round++) {
+    for (i = 0; i < 40; i++) {
+      sprintf(str, "%lu.%lu.0-rc.%lu", (unsigned long) (i % 5), (unsigned long) i,
+              (unsigned long) (i * round % 3));
+      assert(semver_parse(str, &expected) == 0);
+      assert(semver_parse_cached(&cache, str, &ver) == 0);
+      assert(semver_compare_ptr(ver, &expected) == 0);
+      assert(strcmp(ver->prerelease, expected.prerelease) == 0);
+      semver_free(&expected);
+    }
+  }
+  assert(cache.len == 8);
+  assert(cache.hits + cache.misses == 120);
+  assert(cache.misses - cache.evictions == 8);
+  semver_cache_free(&cache);
+  assert(cache.len == 0 && cache.cap == 8 && cache.hits == 0);
+
+  test_end();
+}
+
+void
+test_intern() {
+  test_start("semver_intern");
+
+  semver_intern_t table;
+  const semver_t *ver;
+  semver_key_t key, expected;
+  size_t a, b, c, id;
+  char str[32];
+  int i;
+
+  assert(semver_intern_init(&table, 40) == 0);
+  assert(semver_intern(&table, "1.2.3-beta.1+sha.5", &a) == 0);
+  assert(semver_intern(&table, "1.2.3", &b) == 0);
+  assert(semver_intern(&table, "1.2.3-beta.1+sha.5", &c) == 0);
+  assert(a == c && a != b);
+  assert(semver_intern(&table, "v1.2.3", &id) == -1);
+  assert(table.len == 2);
+
+  ver = semver_intern_get(&table, a);
+  assert(ver->major == 1 && ver->minor == 2 && ver->patch == 3);
+  assert(strcmp(ver->prerelease, "beta.1") == 0);
+  assert(strcmp(ver->metadata, "sha.5") == 0);
+  assert(semver_intern_get(&table, b)->prerelease == NULL);
+
+  assert(semver_intern_key(&table, a, &key) == semver_key(ver, &expected));
+  assert(semver_key_compare(&key, &expected) == 0);
+
+  assert(semver_intern_key(&table, b, &key) == 1);
+  assert(semver_intern_find(&table, "1.2.3", &id) == 0 && id == b);
+  assert(semver_intern_find(&table, "1.2.4", &id) == -1);
+
+  /* IDs stay stable as the table fills up, until it is full */
+  for (i = 0; i < 38; i++) {
+    sprintf(str, "0.%d.0", i);
+    assert(semver_intern(&table, str, &id) == 0);
+    assert(semver_intern_get(&table, id)->minor == i);
+  }
+  assert(semver_intern(&table, "9.9.9", &id) == -1);
+  assert(semver_intern(&table, "1.2.3", &id) == 0 && id == b);
+  assert(semver_intern_find(&table, "1.2.3-beta.1+sha.5", &id) == 0 && id == a);
+  assert(table.len == 40);
+
+  semver_intern_free(&table);
+  test_end();
+}
+
+void
+test_stats() {
+  test_start("semver_stats");
+
+  semver_stats_t stats;
+  semver_view_t view;
+  semver_t ver, other;
+  size_t k, parses;
+
+  semver_stats_reset();
+  assert(semver_parse("1.2.3-alpha.1", &ver) == 0);
+  assert(semver_parse("1.2.3-beta", &other) == 0);
+  assert(semver_parse_view("1.2", 3, &view) == 0);
+  assert(semver_parse_view("1.2.x", 5, &view) == -1);
+  assert(semver_compare(ver, other) == -1);
+  assert(semver_satisfies_op(&ver, &other, SEMVER_OP_LT) == 1);
+  semver_stats_snapshot(&stats);
+
+  for (k = 0, parses = 0; k < SEMVER_STATS_BUCKETS; k++) parses += stats.latency[k];
+#ifdef SEMVER_STATS
+  assert(stats.count[SEMVER_STAT_PARSE] == 4);
+  assert(stats.count[SEMVER_STAT_PARSE_INVALID] == 1);
+  assert(stats.count[SEMVER_STAT_COMPARE] == 2);
+  assert(stats.count[SEMVER_STAT_PRERELEASE_COMPARE] == 2);
+  assert(stats.count[SEMVER_STAT_PRERELEASE_STRING] == 2);
+  assert(stats.count[SEMVER_STAT_SATISFIES] == 1);
+  assert(stats.count[SEMVER_STAT_RANGE_MATCH] == 0);
+  assert(stats.count[SEMVER_STAT_ALLOCS] == 2);
+  assert(stats.count[SEMVER_STAT_ALLOC_BYTES] == sizeof("alpha.1") + sizeof("beta"));
+#ifdef SEMVER_STATS_LATENCY
+  assert(parses == 4);
+#else
+  assert(parses == 0);
+#endif
+
+  semver_stats_reset();
+  semver_stats_snapshot(&stats);
+  for (k = 0, parses = 0; k < SEMVER_STATS_BUCKETS; k++) parses += stats.latency[k];
+#endif
+
+  /* Everything is zero after a reset, or when not compiled in */
+  for (k = 0; k < SEMVER_STAT_COUNT; k++) assert(stats.count[k] == 0);
+  assert(parses == 0);
+
+  semver_free(&ver);
+  semver_free(&other);
+
+  test_end();
+}
+
 void
 test_bump() {
   test_start("bump");
@@ -674,6 +2429,59 @@ test_valid_chars() {
   test_end();
 }
 
+void
+test_valid_batch() {
+  test_start("valid_batch");
+
+  char buf[320];
+  const char *strs[12];
+  unsigned char bitmap[2];
+  size_t i, offset;
+
+  /* Exercise every alignment and the length limit around chunk boundaries */
+  for (offset = 0; offset < 32; offset++) {
+    memset(buf, 'a', sizeof(buf));
+    buf[offset + 255] = '\0';
+    assert(semver_is_valid(buf + offset) == 1);
+    buf[offset + 255] = 'a';
+    buf[offset + 256] = '\0';
+    assert(semver_is_valid(buf + offset) == 0);
+    buf[offset + 40] = '\0';
+    assert(semver_is_valid(buf + offset) == 1);
+    buf[offset + 39] = '@';
+    assert(semver_is_valid(buf + offset) == 0);
+    buf[offset + 39] = (char) 0xc1;
+    assert(semver_is_valid(buf + offset) == 0);
+    buf[offset + 39] = '+';
+    buf[offset + 41] = '$';
+    assert(semver_is_valid(buf + offset) == 1);
+  }
+
+  strs[0] = "1.2.3";
+  strs[1] = "1.2.3-beta.1+build";
+  strs[2] = "v1.2.3 ";
+  strs[3] = "";
+  strs[4] = NULL;
+  strs[5] = "latest";
+  strs[6] = "1.0.0@sha256";
+  strs[7] = "[1.2.3]";
+  strs[8] = "2.0.0-RC.1";
+  strs[9] = "~1";
+  strs[10] = "1_0";
+  strs[11] = "1.0.0";
+
+  assert(semver_is_valid_batch(strs, 12, bitmap) == 6);
+  assert(bitmap[0] == 0x2b);
+  assert(bitmap[1] == 0x09);
+
+  for (i = 0; i < 12; i++) {
+    int bit = (bitmap[i / 8] >> (i % 8)) & 1;
+    assert(bit == (strs[i] != NULL && semver_is_valid(strs[i])));
+  }
+
+  test_end();
+}
+
 void
 test_clean() {
   test_start("clean");
@@ -703,6 +2511,13 @@ main() {
   test_parse_prerelease();
   test_parse_metadata();
   test_parse_prerelerease_metadata();
+  test_parse_invalid();
+  test_parse_batch();
+  test_parse_arena();
+  test_parse_view();
+  test_scan();
+  test_scan_split();
+  test_scan_file();
 
   /* Comparison */
   test_compare();
@@ -715,10 +2530,35 @@ main() {
   test_compare_gte();
   test_compare_lte();
   test_satisfies();
+  test_compare_ptr();
+  test_op();
+  test_column();
+  test_view_compare();
+  test_view_satisfies();
+  test_prerelease_tokens();
+  test_range();
+  test_range_algebra();
+  test_index();
 
   /* Renders */
   test_render();
+  test_render_n();
+  test_render_batch();
   test_numeric();
+  test_key();
+  test_sort();
+  test_merge();
+#ifdef SEMVER_THREADS
+  test_parse_sort_parallel();
+#endif
+  test_bitmap();
+  test_pack();
+  test_hash();
+  test_set();
+  test_counter();
+  test_cache();
+  test_intern();
+  test_stats();
 
   /* Modifiers */
   test_bump();
@@ -730,6 +2570,7 @@ main() {
 
   /* Helpers */
   test_valid_chars();
+  test_valid_batch();
   test_clean();
 
   return 0;